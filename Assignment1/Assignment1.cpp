@@ -1,45 +1,123 @@
 #include <cstdio>
+#include <cstdlib>
+#include <cstring>
 #include <iostream>
 #include <set>
 #include <map>
+#include <sstream>
 #include <stack>
 
+#include "llvm/ADT/BitVector.h"
+#include "llvm/IR/Dominators.h"
 #include "llvm/IR/LLVMContext.h"
 #include "llvm/IR/Module.h"
 #include "llvm/IR/Function.h"
 #include "llvm/IR/Instructions.h"
 #include "llvm/IR/Instruction.h"
+#include "llvm/IR/LegacyPassManager.h"
 #include "llvm/IRReader/IRReader.h"
+#include "llvm/Pass.h"
+#include "llvm/Support/CommandLine.h"
 #include "llvm/Support/SourceMgr.h"
 #include "llvm/Support/raw_ostream.h"
 #include "llvm/Support/raw_ostream.h"
+#include "llvm/Transforms/IPO/PassManagerBuilder.h"
+
+#include "../common/AnalysisStats.h"
+#include "../common/BlockGraph.h"
+#include "../common/Dataflow.h"
+#include "../common/ModuleLoader.h"
+#include "../common/PassPlugin.h"
+#include "../common/PrePass.h"
 
 using namespace llvm;
 
 std::string getSimpleNodeLabel(const BasicBlock *Node);
 std::string getSimpleVarName(const Instruction* Ins);
+void enumeratePaths(const BlockGraph &G, std::map<std::string,std::set<std::string>> &blockInitMap);
+void solveDefinitelyInitialized(Function *F, const BlockGraph &G, std::map<std::string,std::set<std::string>> &blockInitMap);
+void solveInitialized(Function *F, bool definite, std::map<std::string,std::set<std::string>> &blockInitMap);
+void printInitialized(std::ostream &out, const std::map<std::string,std::set<std::string>> &blockInitMap);
+
+AnalysisStats stats;
+#ifndef CS5218_PLUGIN
 int main(int argc, char **argv)
 {
     // Read the IR file.
     LLVMContext &Context = getGlobalContext();
     SMDiagnostic Err;
 
+    // Options: --stats[=file] writes run statistics as JSON (to stderr by default),
+    // --definite reports the variables initialized on every path instead of on some path,
+    // --prepass=list simplifies the CFG first (see PrePass.h)
+    const char *inputFile = nullptr;
+    bool writeStats = false;
+    const char *statsFile = nullptr;
+    bool definite = false;
+    PrePassOptions prePasses;
+    for (int i = 1; i < argc; i++)
+    {
+      if (!strcmp(argv[i], "--stats"))
+        writeStats = true;
+      else if (!strncmp(argv[i], "--stats=", 8))
+      {
+        writeStats = true;
+        statsFile = argv[i] + 8;
+      }
+      else if (!strcmp(argv[i], "--definite"))
+        definite = true;
+      else if (!strncmp(argv[i], "--prepass=", 10))
+      {
+        if (!parsePrePasses(argv[i] + 10, prePasses))
+          return EXIT_FAILURE;
+      }
+      else
+        inputFile = argv[i];
+    }
+    if (inputFile == nullptr)
+    {
+      fprintf(stderr, "usage: %s [--stats[=file]] [--definite] [--prepass=list] <file.ll|file.c>\n", argv[0]);
+      return EXIT_FAILURE;
+    }
+
     // Extract Module M from IR (assuming only one Module exists)
-    Module *M = ParseIRFile(argv[1], Err, Context);
+    StatsPhase parsePhase(stats, "parse");
+    Module *M = loadModule(inputFile, Err, Context);
     if (M == nullptr)
     {
-      fprintf(stderr, "error: failed to load LLVM IR file \"%s\"", argv[1]);
+      fprintf(stderr, "error: failed to load LLVM IR file \"%s\"", inputFile);
       return EXIT_FAILURE;
     }
+    parsePhase.stop();
     
     std::map<std::string,std::set<std::string>> blockInitMap;
     // 1.Extract Function main from Module M
     Function *F = M->getFunction("main");
-    for (auto &BB: *F){
+    runPrePasses(*F, prePasses);
+    solveInitialized(F, definite, blockInitMap);
+    
+    StatsPhase outputPhase(stats, "output");
+    printInitialized(std::cout, blockInitMap);
+    outputPhase.stop();
+
+    if (writeStats)
+    {
+      writeStatsReport(stats, statsFile, "Assignment1", inputFile);
+    }
+    return 0;
+}
+#endif
+
+// Initialized variables of every block of F, by block label: on some path
+// by default, on every path when definite
+void solveInitialized(Function *F, bool definite, std::map<std::string,std::set<std::string>> &blockInitMap){
+    StatsPhase initPhase(stats, "init");
+    BlockGraph G(F);
+    for (unsigned b = 0; b < G.size(); b++){
         std::set<std::string> emptySet;
-        std::string blockName = getSimpleNodeLabel(&BB);
+        const std::string &blockName = G.labels[b];
     	//llvm::outs() << "Label:" << blockName << "\n";
-        for(auto &I : BB){
+        for(auto &I : *G.blocks[b]){
            if(isa<StoreInst>(I)) { 
                 Value* v = I.getOperand(1);
 		std::string var = getSimpleVarName(dyn_cast<Instruction>(v));
@@ -50,34 +128,59 @@ int main(int argc, char **argv)
 	}
 	blockInitMap[blockName] = emptySet;
     }
+    initPhase.stop();
    
+    if (definite){
+      StatsPhase dominatorPhase(stats, "dominators");
+      solveDefinitelyInitialized(F, G, blockInitMap);
+    }else{
+      enumeratePaths(G, blockInitMap);
+    }
+    stats.set("blocks", G.size());
+}
+
+void printInitialized(std::ostream &out, const std::map<std::string,std::set<std::string>> &blockInitMap){
+	std::map<std::string,std::set<std::string>>::const_iterator ite;
+        for(ite = blockInitMap.begin(); ite != blockInitMap.end(); ite++) {
+        out << "Block name:"<< ite->first << std::endl;
+        out << "initialized varabile have: ";
+           std::set<std::string>::const_iterator siter;
+           for( siter = ite->second.begin();siter != ite->second.end(); siter++){
+           out << *siter << " ";
+           }
+           out << std::endl;
+        }
+}
+
+// Every path from the entry to an exit block, in depth-first order; each
+// block on a path gets the stores of the blocks before it.
+void enumeratePaths(const BlockGraph &G, std::map<std::string,std::set<std::string>> &blockInitMap){
     // 2. Traversing the CFG in Depth First Order
     // In order to do so, we use a stack: traversalStack.
-    // First, we add the entry basic block and a integer 0 representing depth to 
+    // First, we add the entry basic block (id 0) and a integer 0 representing depth to 
     // the stack. The depth represents the distance of the BB from entryBB.  
-    std::stack<std::pair<BasicBlock*,int>> traversalStack;
-    BasicBlock* entryBB = &F->getEntryBlock();
-    std::pair<BasicBlock*,int > succAnalysisNode = std::make_pair(entryBB,0);
+    std::stack<std::pair<unsigned,int>> traversalStack;
+    std::pair<unsigned,int > succAnalysisNode = std::make_pair(0u,0);
     traversalStack.push(succAnalysisNode);
     // 3. while the stack is not empty we pop the top Basic Block, print it and
     // add it's successor nodes to the stack plus an updated integer
     std::map<int,std::string> routes;
+    StatsPhase traversalPhase(stats, "traversal");
     while(!traversalStack.empty()){
+        STATS_COUNT(stats, "blocks_visited");
         // Pop the top Basic Block and the depth from stack
-        std::pair<BasicBlock*,int > succAnalysisNode = traversalStack.top();
-        BasicBlock* BB = succAnalysisNode.first;
+        std::pair<unsigned,int > succAnalysisNode = traversalStack.top();
+        unsigned BB = succAnalysisNode.first;
         int depth = succAnalysisNode.second;
       	traversalStack.pop();
       	
-        routes[depth] = getSimpleNodeLabel(BB);
+        routes[depth] = G.labels[BB];
 
 	
-        // Extract the last instruction in the stack (Terminator Instruction)
-        const TerminatorInst *TInst = BB->getTerminator();
-        
-        // Extract the number of successors the terminator instructor has
-	int NSucc = TInst->getNumSuccessors();
+        // Extract the number of successors of the block
+	int NSucc = G.numSuccs(BB);
         if(0 == NSucc){
+          STATS_COUNT(stats, "paths");
           std::map<int,std::string> ::iterator iter;
           iter=routes.begin();
           // update the block init variable at the same time
@@ -85,6 +188,7 @@ int main(int argc, char **argv)
           root = blockInitMap[iter->second];
           for(int i = 0; i<= depth; i++){
             if(i != 0){
+             STATS_COUNT(stats, "join");
              blockInitMap[iter->second].insert(root.begin(),root.end());
              root = blockInitMap[iter->second];
             }
@@ -95,23 +199,130 @@ int main(int argc, char **argv)
 	for (int i = 0;  i < NSucc; ++i) {
             // For all successor basic blocks, add them to the stack
 	    // Increase the value of depth by 1
-            BasicBlock *Succ = TInst->getSuccessor(i);    
-            std::pair<BasicBlock*,int > succAnalysisNode = std::make_pair(Succ,depth+1);
+            unsigned Succ = G.succBegin(BB)[i];
+            std::pair<unsigned,int > succAnalysisNode = std::make_pair(Succ,depth+1);
             traversalStack.push(succAnalysisNode);
     	}	
     }
-    
-	std::map<std::string,std::set<std::string>>::iterator ite;
-        for(ite = blockInitMap.begin(); ite != blockInitMap.end(); ite++) {
-        std::cout << "Block name:"<< ite->first << std::endl;
-        std::cout << "initialized varabile have: ";
-           std::set<std::string>::iterator siter;
-           for( siter = ite->second.begin();siter != ite->second.end(); siter++){
-           std::cout << *siter << " ";
-           }
-           std::cout << std::endl;
+    traversalPhase.stop();
+}
+
+// Must-dataflow over the open variables: a block's output is the
+// intersection of its reachable predecessors' outputs (everything at
+// first, nothing at the entry) plus its own stores.
+struct DefiniteProblem : dataflow::Problem<DefiniteProblem, dataflow::BitSetLattice> {
+    const BlockGraph &G;
+    std::vector<BitVector> gen, out;
+    DefiniteProblem(const BlockGraph &G, unsigned numVars) : G(G), gen(G.size(), BitVector(numVars)), out(G.size(), BitVector(numVars, true)) {}
+
+    void beginSweep(unsigned c){
+        STATS_COUNT(stats, "fallback_rounds");
+    }
+    void input(unsigned b, BitVector &in){
+        in = BitVector(gen[b].size(), b != 0);
+    }
+    void joinEdge(BitVector &in, unsigned from, unsigned slot){
+        if (G.rpoNumber[from] != BlockGraph::NOT_REACHABLE)
+            Lattice::meet(in, out[from]);
+    }
+    bool transfer(unsigned b, const BitVector &in){
+        BitVector result = in;
+        result |= gen[b];
+        if (result == out[b])
+            return false;
+        out[b] = result;
+        return true;
+    }
+};
+
+// Definitely-initialized variables (--definite). A variable is initialized
+// at the end of B on every path when B or one of its dominators stores to
+// it, which a single walk down the dominator tree settles. That rule only
+// misses variables stored on several branches none of which dominates B,
+// so the variables it leaves open at some join go through the usual
+// must-dataflow (intersection over predecessors, iterated to a fixpoint)
+// over bit vectors holding just those variables. On entry blockInitMap
+// holds each block's own stores; on return the definite sets.
+void solveDefinitelyInitialized(Function *F, const BlockGraph &G, std::map<std::string,std::set<std::string>> &blockInitMap){
+    std::vector<std::set<std::string>> stores(G.size()), initialized(G.size());
+    std::set<std::string> storedAnywhere;
+    for (unsigned b = 0; b < G.size(); b++){
+        stores[b] = blockInitMap[G.labels[b]];
+        storedAnywhere.insert(stores[b].begin(), stores[b].end());
+        initialized[b] = stores[b];
+    }
+
+    DominatorTree DT;
+    DT.recalculate(*F);
+    std::vector<DomTreeNode*> stack(1, DT.getRootNode());
+    while (!stack.empty()){
+        DomTreeNode *node = stack.back();
+        stack.pop_back();
+        unsigned b = G.id(node->getBlock());
+        if (node->getIDom() != nullptr){
+            const std::set<std::string> &above = initialized[G.id(node->getIDom()->getBlock())];
+            initialized[b].insert(above.begin(), above.end());
         }
-    return 0;
+        for (DomTreeNode::iterator child = node->begin(); child != node->end(); ++child)
+            stack.push_back(*child);
+    }
+
+    // Variables the dominator rule leaves open somewhere: a variable is
+    // missed only at a join whose forward predecessors (earlier in reverse
+    // post-order, so not reached through the join itself) all have it
+    // while the join does not. Anywhere else the dominator sets already
+    // are the fixpoint, and the variable needs no fallback.
+    std::vector<std::string> open;
+    for (std::set<std::string>::iterator var = storedAnywhere.begin(); var != storedAnywhere.end(); var++){
+        bool missed = false;
+        for (unsigned i = 1; i < G.rpo.size() && !missed; i++){
+            unsigned b = G.rpo[i];
+            if (initialized[b].count(*var))
+                continue;
+            unsigned forward = 0, reachable = 0;
+            bool allHave = true;
+            for (const unsigned *pred = G.predBegin(b); pred != G.predEnd(b); pred++){
+                if (G.rpoNumber[*pred] == BlockGraph::NOT_REACHABLE)
+                    continue;
+                reachable++;
+                if (G.rpoNumber[*pred] < i){
+                    forward++;
+                    allHave &= initialized[*pred].count(*var) != 0;
+                }
+            }
+            missed = reachable > 1 && forward > 0 && allHave;
+        }
+        if (missed)
+            open.push_back(*var);
+    }
+    stats.set("fallback_vars", open.size());
+
+    if (!open.empty()){
+        DefiniteProblem problem(G, open.size());
+        for (unsigned b = 0; b < G.size(); b++){
+            for (unsigned v = 0; v < open.size(); v++){
+                if (stores[b].count(open[v]))
+                    problem.gen[b].set(v);
+            }
+        }
+        // components in topological order: a block on no cycle is final
+        // after one evaluation, a loop is swept until it is stable
+        for (unsigned c = 0; c < G.numSccs(); c++){
+            if (G.rpoNumber[*G.sccBegin(c)] != BlockGraph::NOT_REACHABLE)
+                dataflow::solveScc(problem, G, c);
+        }
+        const std::vector<BitVector> &out = problem.out;
+        for (unsigned i = 0; i < G.rpo.size(); i++){
+            unsigned b = G.rpo[i];
+            for (unsigned v = 0; v < open.size(); v++){
+                if (out[b].test(v))
+                    initialized[b].insert(open[v]);
+            }
+        }
+    }
+
+    for (unsigned b = 0; b < G.size(); b++)
+        blockInitMap[G.labels[b]] = initialized[b];
 }
 
 std::string getSimpleVarName(const Instruction* Ins){
@@ -125,6 +336,9 @@ if (!Ins->getName().empty())
 
 // Printing Basic Block Label 
 std::string getSimpleNodeLabel(const BasicBlock *Node) {
+    std::map<const BasicBlock*, std::string>::const_iterator renamed = prePassLabels().find(Node);
+    if (renamed != prePassLabels().end())
+        return renamed->second;
     if (!Node->getName().empty())
         return Node->getName().str();
     std::string Str;
@@ -132,3 +346,39 @@ std::string getSimpleNodeLabel(const BasicBlock *Node) {
     Node->printAsOperand(OS, false);
     return OS.str();
 }
+
+#ifdef CS5218_PLUGIN
+// Pass plugin (see PassPlugin.h): the initialized variables of main,
+// written to <input>.init or -cs5218-init-output; -cs5218-init-definite
+// selects the --definite analysis
+namespace {
+cl::opt<std::string> InitOutput("cs5218-init-output", cl::desc("file the cs5218-init report is written to"), cl::value_desc("file"));
+cl::opt<bool> InitDefinite("cs5218-init-definite", cl::desc("report the variables initialized on every path"));
+
+struct InitializedPass : public FunctionPass {
+    static char ID;
+    InitializedPass() : FunctionPass(ID) {}
+
+    bool runOnFunction(Function &F) override {
+        if (F.getName() != "main" || F.empty())
+            return false;
+        std::map<std::string,std::set<std::string>> blockInitMap;
+        solveInitialized(&F, InitDefinite, blockInitMap);
+        std::ostringstream report;
+        printInitialized(report, blockInitMap);
+        writePluginOutput(pluginOutputPath(*F.getParent(), InitOutput, ".init"), report.str());
+        return false;
+    }
+    void getAnalysisUsage(AnalysisUsage &AU) const override {
+        AU.setPreservesAll();
+    }
+};
+}
+
+char InitializedPass::ID = 0;
+static RegisterPass<InitializedPass> RegisterInitialized("cs5218-init", "CS5218 initialized variables of main", false, true);
+static void addInitializedPass(const PassManagerBuilder &, legacy::PassManagerBase &PM){
+    PM.add(new InitializedPass());
+}
+static RegisterStandardPasses RegisterInitializedInClang(PassManagerBuilder::EP_EarlyAsPossible, addInitializedPass);
+#endif
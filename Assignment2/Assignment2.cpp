@@ -1,70 +1,667 @@
+#include <cstdint>
 #include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
 #include <iostream>
+#include <algorithm>
+#include <iterator>
 #include <list>
 #include <map>
+#include <sstream>
 #include <stack>
 #include <set>
+#include "llvm/ADT/BitVector.h"
 #include "llvm/IR/LLVMContext.h"
 #include "llvm/IR/Module.h"
 #include "llvm/IR/Function.h"
 #include "llvm/IR/Instructions.h"
 #include "llvm/IR/Instruction.h"
+#include "llvm/IR/LegacyPassManager.h"
 #include "llvm/IRReader/IRReader.h"
+#include "llvm/Pass.h"
+#include "llvm/Support/CommandLine.h"
 #include "llvm/Support/SourceMgr.h"
 #include "llvm/Support/raw_ostream.h"
 #include "llvm/Support/raw_ostream.h"
+#include "llvm/Transforms/IPO/PassManagerBuilder.h"
+
+#include "../common/AnalysisStats.h"
+#include "../common/BlockGraph.h"
+#include "../common/Dataflow.h"
+#include "../common/ModuleLoader.h"
+#include "../common/Daemon.h"
+#include "../common/PassPlugin.h"
+#include "../common/PrePass.h"
+#include "../common/PointsTo.h"
 
 using namespace llvm;
 
 std::string getSimpleNodeLabel(const BasicBlock *Node);
 std::string getSimpleVarName(const Instruction* Ins);
+std::string handleRequest(const std::vector<std::string> &words);
+std::string getLocationName(PointsToGraph &PT, Value *address, std::map<std::string,std::set<std::string>> &locationMembers);
 struct AffectItem
 {
     std::string key;
     std::set<std::string> vals;
+    // a strong store overwrites its location, a weak one (through a pointer
+    // that may reach several variables) can only add taint to it
+    bool strong;
+};
+
+// Dense ids for location names, so taint sets are bit vectors
+struct LocationTable
+{
+    std::map<std::string,unsigned> ids;
+    std::vector<std::string> names;
+    unsigned intern(const std::string &name){
+        std::map<std::string,unsigned>::iterator it = ids.find(name);
+        if (it != ids.end())
+            return it->second;
+        ids[name] = names.size();
+        names.push_back(name);
+        return names.size() - 1;
+    }
+};
+
+// Effect of a run of store items on a taint set. Every item sets its key
+// to "some location it reads is tainted" (a weak store keeps the key's
+// own taint as well), so after any sequence of items each written
+// location is tainted exactly when one of a fixed set of entry locations
+// was: its mask. Locations outside `written` pass through unchanged.
+// then() composes the summaries of a block's items, in order, into the
+// block's summary, which is built once and applied on every round with one
+// mask test per written location. Summaries are not composed across
+// blocks: every block's own taint set is reported, so each block applies
+// its own summary.
+struct TransferSummary
+{
+    BitVector written;
+    std::map<unsigned,BitVector> masks;
+
+    explicit TransferSummary(unsigned numLocations) : written(numLocations) {}
+
+    static TransferSummary fromItem(const AffectItem &item, LocationTable &locations){
+        TransferSummary summary(locations.names.size());
+        unsigned key = locations.ids[item.key];
+        BitVector mask(locations.names.size());
+        for (std::set<std::string>::const_iterator val = item.vals.begin(); val != item.vals.end(); val++)
+            mask.set(locations.ids[*val]);
+        if (!item.strong)
+            mask.set(key);
+        summary.written.set(key);
+        summary.masks[key] = mask;
+        return summary;
+    }
+
+    BitVector apply(const BitVector &in) const{
+        BitVector out = in;
+        out.reset(written);
+        for (std::map<unsigned,BitVector>::const_iterator it = masks.begin(); it != masks.end(); it++){
+            if (in.anyCommon(it->second))
+                out.set(it->first);
+        }
+        return out;
+    }
+
+    // apply() over label masks of `words` words per location, stored
+    // location after location: a written location gets the OR of its
+    // mask's locations, a word at a time
+    std::vector<uint64_t> applyLabels(const std::vector<uint64_t> &in, unsigned words) const{
+        std::vector<uint64_t> out = in;
+        for (int key = written.find_first(); key != -1; key = written.find_next(key))
+            std::fill(out.begin() + key * words, out.begin() + (key + 1) * words, 0);
+        for (std::map<unsigned,BitVector>::const_iterator it = masks.begin(); it != masks.end(); it++){
+            uint64_t *target = &out[it->first * words];
+            for (int id = it->second.find_first(); id != -1; id = it->second.find_next(id)){
+                const uint64_t *source = &in[id * words];
+                for (unsigned w = 0; w < words; w++)
+                    target[w] |= source[w];
+            }
+        }
+        return out;
+    }
+
+    // This summary followed by next
+    TransferSummary then(const TransferSummary &next) const{
+        TransferSummary result = *this;
+        result.written |= next.written;
+        for (std::map<unsigned,BitVector>::const_iterator it = next.masks.begin(); it != next.masks.end(); it++){
+            // next reads our output: a location we wrote stands for its mask
+            BitVector mask = it->second;
+            mask.reset(written);
+            for (int id = it->second.find_first(); id != -1; id = it->second.find_next(id)){
+                if (written.test(id))
+                    mask |= masks.find(id)->second;
+            }
+            result.masks[it->first] = mask;
+        }
+        return result;
+    }
+};
+
+// Source-to-sink reachability (--reach): only decide whether the sink (see
+// TaintSpec) is tainted in any block, instead of solving every taint set.
+struct ReachQuery
+{
+    // also search backward from the sink, meeting the forward search
+    bool bidirectional;
+    // verdict, and how it was reached
+    bool tainted;
+    std::string reason;
+    ReachQuery() : bidirectional(false), tainted(false) {}
+};
+
+// Where taint came from (--witness). While the fixpoint runs, the first
+// time a location becomes tainted at the end of a block, parent records the
+// (block, location) whose taint set it, as one index block * numLocations +
+// location: the same location in the predecessor (or the block's own
+// previous state) it was carried from, or the location a store of the block
+// read. A source points to itself. A path back to the source is only
+// rebuilt from these pointers when asked for.
+struct TaintProvenance
+{
+    enum { NONE = ~0u };
+    std::vector<unsigned> parent;
+    unsigned numLocations;
+    std::vector<std::string> blocks;
+    std::vector<std::string> locations;
+    // location of the sink, when the function has one
+    bool hasSink;
+    unsigned sinkId;
+    TaintProvenance() : numLocations(0), hasSink(false), sinkId(0) {}
+
+    // The (block, location) steps from a source to location at the end of
+    // block, source first; empty when it was never tainted there
+    std::vector<unsigned> path(unsigned block, unsigned location) const{
+        std::vector<unsigned> steps;
+        unsigned node = block * numLocations + location;
+        if (parent[node] == NONE)
+            return steps;
+        steps.push_back(node);
+        while (parent[node] != node){
+            node = parent[node];
+            steps.push_back(node);
+        }
+        std::reverse(steps.begin(), steps.end());
+        return steps;
+    }
+};
+
+// Sources, sinks and taint labels (--taint-spec=file). By default the
+// variable named "source" is the one source, with one label, and the one
+// named "sink" is the sink. A spec file has one directive per line:
+//
+//     source LABEL VAR...    every VAR is a source of taint LABEL
+//     sink VAR [LABEL...]    VAR must not receive any of the LABELs (any
+//                            label at all when none is listed)
+//
+// and # starts a comment. Under a spec every label is propagated in the
+// same fixpoint: each location carries a mask of them (see
+// LabelTaintProblem).
+struct TaintSpec
+{
+    std::vector<std::string> labels;
+    // variable -> its labels, and sink -> the labels it must not receive
+    std::map<std::string,std::vector<unsigned>> sources;
+    std::map<std::string,std::vector<unsigned>> sinks;
+    bool multiLabel;
+    TaintSpec() : labels(1, "source"), multiLabel(false){
+        sources["source"].push_back(0);
+        sinks["sink"].push_back(0);
+    }
+    // 64-bit words in a label mask
+    unsigned words() const { return (labels.size() + 63) / 64; }
 };
+TaintSpec taintSpec;
+bool parseTaintSpec(const char *path, TaintSpec &spec);
+
+// Multi-label result: block label -> variable -> mask of taintSpec.labels
+typedef std::map<std::string,std::map<std::string,std::vector<uint64_t>>> LabelTaintMap;
+
+void solveTaint(Function *F, std::map<std::string,std::set<std::string>> &taintMap, ReachQuery *reach = NULL, LabelTaintMap *labelMap = NULL, TaintProvenance *provenance = NULL);
+bool findDependencePath(const std::set<std::string> &sources, const std::string &sink, std::map<std::string,std::set<std::string>> &flowsTo, std::map<std::string,std::set<std::string>> &flowsFrom, bool bidirectional);
+std::set<std::string> dependenceClosure(const std::set<std::string> &start, std::map<std::string,std::set<std::string>> &edges);
+void printTaint(std::ostream &out, const std::map<std::string,std::set<std::string>> &taintMap);
+void printLabelTaint(std::ostream &out, const LabelTaintMap &labelMap);
+void printWitness(std::ostream &out, const TaintProvenance &provenance, const char *block);
+
+AnalysisStats stats;
 
+#ifndef CS5218_PLUGIN
 int main(int argc, char **argv)
 {
     // Read the IR file.
     LLVMContext &Context = getGlobalContext();
     SMDiagnostic Err;
 
+    // Options: --stats[=file] writes run statistics as JSON (to stderr by default),
+    // --daemon=socket serves queries instead of analyzing one file,
+    // --reach[=bidir] only decides whether source reaches sink,
+    // --prepass=list simplifies the CFG first (see PrePass.h),
+    // --taint-spec=file reads sources, sinks and labels (see TaintSpec),
+    // --witness[=block] also prints how source reaches the sink
+    const char *inputFile = nullptr;
+    bool writeStats = false;
+    const char *statsFile = nullptr;
+    const char *daemonSocket = nullptr;
+    bool reachMode = false;
+    ReachQuery reach;
+    bool witnessMode = false;
+    const char *witnessBlock = nullptr;
+    PrePassOptions prePasses;
+    for (int i = 1; i < argc; i++)
+    {
+      if (!strcmp(argv[i], "--stats"))
+        writeStats = true;
+      else if (!strncmp(argv[i], "--stats=", 8))
+      {
+        writeStats = true;
+        statsFile = argv[i] + 8;
+      }
+      else if (!strncmp(argv[i], "--daemon=", 9))
+        daemonSocket = argv[i] + 9;
+      else if (!strcmp(argv[i], "--reach"))
+        reachMode = true;
+      else if (!strcmp(argv[i], "--reach=bidir"))
+      {
+        reachMode = true;
+        reach.bidirectional = true;
+      }
+      else if (!strncmp(argv[i], "--prepass=", 10))
+      {
+        if (!parsePrePasses(argv[i] + 10, prePasses))
+          return EXIT_FAILURE;
+      }
+      else if (!strncmp(argv[i], "--taint-spec=", 13))
+      {
+        if (!parseTaintSpec(argv[i] + 13, taintSpec))
+          return EXIT_FAILURE;
+      }
+      else if (!strcmp(argv[i], "--witness"))
+        witnessMode = true;
+      else if (!strncmp(argv[i], "--witness=", 10))
+      {
+        witnessMode = true;
+        witnessBlock = argv[i] + 10;
+      }
+      else
+        inputFile = argv[i];
+    }
+    // the reachability search has one sink to meet
+    if (reachMode && taintSpec.sinks.size() != 1)
+    {
+      fprintf(stderr, "error: --reach needs exactly one sink in the taint spec\n");
+      return EXIT_FAILURE;
+    }
+    // provenance is kept per location, not per label
+    if (witnessMode && taintSpec.multiLabel)
+    {
+      fprintf(stderr, "error: --witness follows the single-label analysis and cannot be used with --taint-spec\n");
+      return EXIT_FAILURE;
+    }
+    if (daemonSocket != nullptr)
+      return serveRequests(daemonSocket, handleRequest);
+    if (inputFile == nullptr)
+    {
+      fprintf(stderr, "usage: %s [--stats[=file]] [--reach[=bidir]] [--prepass=list] [--taint-spec=file] [--witness[=block]] <file.ll|file.c>\n"
+                      "       %s --daemon=socket\n", argv[0], argv[0]);
+      return EXIT_FAILURE;
+    }
+
     // Extract Module M from IR (assuming only one Module exists)
-    Module *M = ParseIRFile(argv[1], Err, Context);
+    StatsPhase parsePhase(stats, "parse");
+    Module *M = loadModule(inputFile, Err, Context);
     if (M == nullptr)
     {
-      fprintf(stderr, "error: failed to load LLVM IR file \"%s\"", argv[1]);
+      fprintf(stderr, "error: failed to load LLVM IR file \"%s\"", inputFile);
       return EXIT_FAILURE;
     }
+    parsePhase.stop();
     
-    std::map<std::string,std::vector<AffectItem>> blockAffectMap;
-    std::set<std::string> allocate_vars = std::set<std::string>();
-    std::map<std::string,std::set<std::string>> resultMap;
-    std::map<std::string,std::set<std::string>> previousBlockMap;
-    std::list<std::string> blockOrder;
-    std::map<std::string,int> blockStatus;
     // 1.Extract Function main from Module M
     Function *F = M->getFunction("main");
+    runPrePasses(*F, prePasses);
+    std::map<std::string,std::set<std::string>> taintMap;
+    TaintProvenance provenance;
+    if (reachMode)
+    {
+      // exit status 0 when the sink is clean, 2 when source reaches it
+      solveTaint(F, taintMap, &reach, NULL, witnessMode ? &provenance : NULL);
+      std::cout << (reach.tainted ? "tainted: " : "clean: ") << reach.reason << std::endl;
+      if (witnessMode && reach.tainted && provenance.numLocations != 0)
+        printWitness(std::cout, provenance, witnessBlock);
+      if (writeStats)
+        writeStatsReport(stats, statsFile, "Assignment2", inputFile);
+      return reach.tainted ? 2 : 0;
+    }
+    if (taintSpec.multiLabel)
+    {
+      LabelTaintMap labelMap;
+      solveTaint(F, taintMap, NULL, &labelMap);
+      StatsPhase outputPhase(stats, "output");
+      printLabelTaint(std::cout, labelMap);
+      outputPhase.stop();
+    }
+    else
+    {
+      solveTaint(F, taintMap, NULL, NULL, witnessMode ? &provenance : NULL);
+      StatsPhase outputPhase(stats, "output");
+      printTaint(std::cout, taintMap);
+      if (witnessMode)
+        printWitness(std::cout, provenance, witnessBlock);
+      outputPhase.stop();
+    }
+    
+    if (writeStats)
+    {
+      writeStatsReport(stats, statsFile, "Assignment2", inputFile);
+    }
+    
+    return 0;
+}
+#endif
+
+// Print the taint of every block, in label order
+void printTaint(std::ostream &out, const std::map<std::string,std::set<std::string>> &taintMap){
+	std::map<std::string,std::set<std::string>>::const_iterator ite;
+        for(ite = taintMap.begin(); ite != taintMap.end(); ite++) {
+        out << "Block name:"<< ite->first << std::endl;
+        out << "taint varabile have: ";
+           std::set<std::string>::const_iterator siter;
+           for( siter = ite->second.begin();siter != ite->second.end(); siter++){
+           out << *siter << " ";
+           }
+           out << std::endl;
+        }
+}
+
+// Multi-label taint of every block, each variable with its labels, then
+// every sink of taintSpec with the forbidden labels it receives and where
+void printLabelTaint(std::ostream &out, const LabelTaintMap &labelMap){
+    for (LabelTaintMap::const_iterator block = labelMap.begin(); block != labelMap.end(); block++){
+        out << "Block name:" << block->first << std::endl;
+        out << "taint varabile have: ";
+        for (auto var = block->second.begin(); var != block->second.end(); var++){
+            out << var->first << "{";
+            const char *separator = "";
+            for (unsigned l = 0; l < taintSpec.labels.size(); l++){
+                if (var->second[l / 64] >> (l % 64) & 1){
+                    out << separator << taintSpec.labels[l];
+                    separator = ",";
+                }
+            }
+            out << "} ";
+        }
+        out << std::endl;
+    }
+    for (auto sink = taintSpec.sinks.begin(); sink != taintSpec.sinks.end(); sink++){
+        out << "sink " << sink->first << ":";
+        bool clean = true;
+        for (size_t i = 0; i < sink->second.size(); i++){
+            unsigned l = sink->second[i];
+            std::string blocks;
+            for (LabelTaintMap::const_iterator block = labelMap.begin(); block != labelMap.end(); block++){
+                auto var = block->second.find(sink->first);
+                if (var != block->second.end() && (var->second[l / 64] >> (l % 64) & 1))
+                    blocks += " " + block->first;
+            }
+            if (blocks.empty())
+                continue;
+            out << (clean ? " " : "; ") << taintSpec.labels[l] << " in" << blocks;
+            clean = false;
+        }
+        out << (clean ? " clean" : "") << std::endl;
+    }
+}
+
+// How source reaches the sink at the end of block (or of the first block
+// where it is tainted, when block is NULL), one step per line: a store
+// that moved taint to another location, or a block it was carried into
+void printWitness(std::ostream &out, const TaintProvenance &provenance, const char *block){
+    if (!provenance.hasSink){
+        out << "witness: no sink variable" << std::endl;
+        return;
+    }
+    unsigned n = provenance.numLocations;
+    unsigned target = TaintProvenance::NONE;
+    for (unsigned b = 0; b < provenance.blocks.size() && target == TaintProvenance::NONE; b++){
+        if (block != NULL ? provenance.blocks[b] == block : provenance.parent[b * n + provenance.sinkId] != TaintProvenance::NONE)
+            target = b;
+    }
+    if (target == TaintProvenance::NONE){
+        if (block != NULL)
+            out << "witness: no block " << block << std::endl;
+        else
+            out << "witness: sink clean" << std::endl;
+        return;
+    }
+    std::vector<unsigned> steps = provenance.path(target, provenance.sinkId);
+    if (steps.empty()){
+        out << "witness: sink clean in " << provenance.blocks[target] << std::endl;
+        return;
+    }
+    out << "witness: sink tainted in " << provenance.blocks[target] << std::endl;
+    for (size_t i = 0; i < steps.size(); i++){
+        unsigned b = steps[i] / n, location = steps[i] % n;
+        out << "  " << provenance.blocks[b] << " " << provenance.locations[location] << ": ";
+        if (i == 0)
+            out << "source";
+        else if (steps[i - 1] % n != location)
+            out << "stored from " << provenance.locations[steps[i - 1] % n];
+        else
+            out << "carried from " << provenance.blocks[steps[i - 1] / n];
+        out << std::endl;
+    }
+}
+
+// Taint as a forward may-dataflow: a block's input is the union of its
+// predecessors' sets and its own previous one, and its summary maps that
+// to its new set. With a ReachQuery the solver stops as soon as the sink
+// is known to be tainted; with a TaintProvenance every newly tainted
+// location records where it came from.
+struct TaintProblem : dataflow::Problem<TaintProblem, dataflow::BitSetLattice> {
+    enum { selfDependent = true };
+    const BlockGraph &G;
+    const std::vector<TransferSummary> &summaries;
+    std::vector<BitVector> &taint;
+    ReachQuery *reach;
+    unsigned sinkId;
+    TaintProvenance *provenance;
+    // A block's set is recomputed from its own previous result, so a store
+    // that kills taint can shrink it; until that has happened every set
+    // only grows, and a tainted sink stays tainted.
+    bool shrunk;
+    bool decided;
+    TaintProblem(const BlockGraph &G, const std::vector<TransferSummary> &summaries, std::vector<BitVector> &taint, ReachQuery *reach, unsigned sinkId, TaintProvenance *provenance)
+        : G(G), summaries(summaries), taint(taint), reach(reach), sinkId(sinkId), provenance(provenance), shrunk(false), decided(false) {}
+
+    bool done() const { return decided; }
+    void beginSweep(unsigned c){
+        STATS_COUNT(stats, "fixpoint_rounds");
+    }
+    void input(unsigned b, BitVector &in){
+        STATS_COUNT(stats, "blocks_evaluated");
+        in = taint[b];
+    }
+    void joinEdge(BitVector &in, unsigned from, unsigned slot){
+        STATS_COUNT(stats, "join");
+        Lattice::join(in, taint[from]);
+    }
+    bool transfer(unsigned b, const BitVector &in){
+        BitVector original_result = taint[b];
+        taint[b] = summaries[b].apply(in);
+        STATS_COUNT(stats, "state_compare");
+        bool changed = taint[b] != original_result;
+        if (changed && provenance != NULL)
+            recordParents(b, in, original_result);
+        if (reach != NULL){
+            if (original_result.reset(taint[b]).any())
+                shrunk = true;
+            if (!shrunk && taint[b].test(sinkId)){
+                reach->tainted = true;
+                reach->reason = "sink tainted in block " + G.labels[b];
+                decided = true;
+            }
+        }
+        return changed;
+    }
+
+    // Set the parent of every location tainted at the end of b for the
+    // first time: a location b writes came from one of its mask's locations
+    // in the input, any other was carried in unchanged; either way from b's
+    // previous state or a predecessor whose state has it
+    void recordParents(unsigned b, const BitVector &in, const BitVector &previous){
+        unsigned n = provenance->numLocations;
+        for (int id = taint[b].find_first(); id != -1; id = taint[b].find_next(id)){
+            unsigned &parent = provenance->parent[b * n + id];
+            if (parent != TaintProvenance::NONE)
+                continue;
+            unsigned from = id;
+            if (summaries[b].written.test(id)){
+                BitVector read = summaries[b].masks.find(id)->second;
+                read &= in;
+                from = read.find_first();
+            }
+            unsigned block = b;
+            for (unsigned slot = G.predOffset[b]; !previous.test(from) && slot != G.predOffset[b + 1]; slot++){
+                // a self loop carries b's previous state, already tested
+                if (G.preds[slot] != b && taint[G.preds[slot]].test(from)){
+                    block = G.preds[slot];
+                    break;
+                }
+            }
+            parent = block * n + from;
+        }
+    }
+};
+
+// Multi-label taint: a block's state holds a mask of taintSpec.labels for
+// every location, words 64-bit words each, in one flat array; the join
+// and the summaries OR whole words, so all labels are solved at once.
+struct LabelTaintProblem : dataflow::Problem<LabelTaintProblem, dataflow::WordSetLattice> {
+    enum { selfDependent = true };
+    const std::vector<TransferSummary> &summaries;
+    std::vector<std::vector<uint64_t>> &taint;
+    unsigned words;
+    LabelTaintProblem(const std::vector<TransferSummary> &summaries, std::vector<std::vector<uint64_t>> &taint, unsigned words)
+        : summaries(summaries), taint(taint), words(words) {}
+
+    void beginSweep(unsigned c){
+        STATS_COUNT(stats, "fixpoint_rounds");
+    }
+    void input(unsigned b, std::vector<uint64_t> &in){
+        STATS_COUNT(stats, "blocks_evaluated");
+        in = taint[b];
+    }
+    void joinEdge(std::vector<uint64_t> &in, unsigned from, unsigned slot){
+        STATS_COUNT(stats, "join");
+        Lattice::join(in, taint[from]);
+    }
+    bool transfer(unsigned b, const std::vector<uint64_t> &in){
+        std::vector<uint64_t> result = summaries[b].applyLabels(in, words);
+        STATS_COUNT(stats, "state_compare");
+        bool changed = result != taint[b];
+        taint[b].swap(result);
+        return changed;
+    }
+};
+
+// Solve every label of taintSpec at once into labelMap, from the block
+// summaries of solveTaint()
+void solveLabels(const BlockGraph &G, const std::vector<TransferSummary> &summaries, LocationTable &locations,
+                 std::map<std::string,std::vector<std::pair<std::string,unsigned>>> &seedLabels,
+                 std::map<std::string,std::set<std::string>> &locationMembers, LabelTaintMap &labelMap){
+    unsigned words = taintSpec.words();
+    unsigned numLocations = locations.names.size();
+    std::vector<std::vector<uint64_t>> taint(G.size(), std::vector<uint64_t>(numLocations * words, 0));
+    for (unsigned b = 0; b < G.size(); b++){
+        const std::vector<std::pair<std::string,unsigned>> &seeds = seedLabels[G.labels[b]];
+        for (size_t i = 0; i < seeds.size(); i++)
+            taint[b][locations.ids[seeds[i].first] * words + seeds[i].second / 64] |= (uint64_t)1 << (seeds[i].second % 64);
+    }
+
+    LabelTaintProblem problem(summaries, taint, words);
+    StatsPhase fixpointPhase(stats, "fixpoint");
+    dataflow::solveBySccs(problem, G);
+    fixpointPhase.stop();
+
+    // a location's mask goes to every variable it stands for
+    labelMap.clear();
+    for (unsigned b = 0; b < G.size(); b++){
+        std::map<std::string,std::vector<uint64_t>> &blockLabels = labelMap[G.labels[b]];
+        for (unsigned id = 0; id < numLocations; id++){
+            const uint64_t *mask = &taint[b][id * words];
+            if (std::find_if(mask, mask + words, [](uint64_t w) { return w != 0; }) == mask + words)
+                continue;
+            const std::string &location = locations.names[id];
+            std::set<std::string> members;
+            if (locationMembers.count(location))
+                members = locationMembers[location];
+            else
+                members.insert(location);
+            for (std::set<std::string>::iterator var = members.begin(); var != members.end(); var++){
+                std::vector<uint64_t> &labels = blockLabels[*var];
+                labels.resize(words, 0);
+                for (unsigned w = 0; w < words; w++)
+                    labels[w] |= mask[w];
+            }
+        }
+    }
+}
+
+// Whether a source of these labels matters to --reach: the spec's one sink
+// only forbids its own labels
+bool reachesSink(const std::vector<unsigned> &labels){
+    const std::vector<unsigned> &forbidden = taintSpec.sinks.begin()->second;
+    for (size_t l = 0; l < labels.size(); l++){
+        if (std::find(forbidden.begin(), forbidden.end(), labels[l]) != forbidden.end())
+            return true;
+    }
+    return false;
+}
+
+// Taint of every block of F, by block label. The result lists variables:
+// a location merged by the points-to analysis taints all its variables.
+void solveTaint(Function *F, std::map<std::string,std::set<std::string>> &taintMap, ReachQuery *reach, LabelTaintMap *labelMap, TaintProvenance *provenance){
+    StatsPhase initPhase(stats, "init");
+    std::map<std::string,std::vector<AffectItem>> blockAffectMap;
+    std::map<std::string,std::set<std::string>> resultMap;
+    // blocks are visited one strongly connected component at a time, and their predecessors come from the graph
+    BlockGraph G(F);
+    // loads and stores name abstract locations from the points-to classes,
+    // so taint flows through pointers; locationMembers lists the variables
+    // each location stands for
+    PointsToGraph PT(F);
+    std::map<std::string,std::set<std::string>> locationMembers;
     std::set<std::string> last_load_var_name_set = std::set<std::string>();
-    for (auto &BB: *F){
+    std::string sinkLocation;
+    // per block: the (location, label) pairs its source allocas introduce
+    std::map<std::string,std::vector<std::pair<std::string,unsigned>>> seedLabels;
+    for (unsigned b = 0; b < G.size(); b++){
         std::vector<AffectItem> affect_values;
-        std::string blockName = getSimpleNodeLabel(&BB);
-        //init the result and previous block relation 
+        const std::string &blockName = G.labels[b];
+        //init the result
         resultMap[blockName] = std::set<std::string>();
-        previousBlockMap[blockName] = std::set<std::string>();
 
-        for(auto &I : BB){
+        for(auto &I : *G.blocks[b]){
            if(isa<AllocaInst>(I)){
                 AllocaInst *allocInst = dyn_cast<AllocaInst>(&I);
-                allocate_vars.insert(allocInst->getName());
-                if("source" == allocInst->getName()){
-                    resultMap[blockName].insert("source");
+                std::map<std::string,std::vector<unsigned>>::const_iterator source = taintSpec.sources.find(allocInst->getName().str());
+                if(source != taintSpec.sources.end() && (reach == NULL || reachesSink(source->second))){
+                    std::string location = getLocationName(PT, allocInst, locationMembers);
+                    resultMap[blockName].insert(location);
+                    for(unsigned l = 0; l < source->second.size(); l++)
+                        seedLabels[blockName].push_back(std::make_pair(location, source->second[l]));
+                }
+                if(taintSpec.sinks.count(allocInst->getName().str())){
+                    sinkLocation = getLocationName(PT, allocInst, locationMembers);
                 }
            }
            if(isa<LoadInst>(I)){
-		        std::string load_var_name = getSimpleVarName(dyn_cast<Instruction>(I.getOperand(0)));
-                if(allocate_vars.find(load_var_name) != allocate_vars.end()){
+		        std::string load_var_name = getLocationName(PT, I.getOperand(0), locationMembers);
+                if(!load_var_name.empty()){
                     last_load_var_name_set.insert(load_var_name);
                 }
 	        }
@@ -74,10 +671,13 @@ int main(int argc, char **argv)
            if(isa<StoreInst>(I)) { 
 		        Value* v = I.getOperand(0);
 		        Instruction * v_0 = dyn_cast<Instruction>(v);
-                std::string var_1 = getSimpleVarName(dyn_cast<Instruction>(I.getOperand(1)));
+                std::string var_1 = getLocationName(PT, I.getOperand(1), locationMembers);
+                if(var_1.empty())
+                    var_1 = getSimpleVarName(dyn_cast<Instruction>(I.getOperand(1)));
+                bool strong = PT.isSingleObject(I.getOperand(1));
                 
-                //remove the item that key = var_1 first
-                for(std::vector<AffectItem>::iterator item = affect_values.begin();item != affect_values.end();){
+                //remove the item that key = var_1 first, unless this store may leave it unchanged
+                for(std::vector<AffectItem>::iterator item = affect_values.begin();strong && item != affect_values.end();){
                     if((*item).key == var_1){
                         item = affect_values.erase(item);
                     }else{
@@ -91,101 +691,303 @@ int main(int argc, char **argv)
                 AffectItem one = AffectItem();
                 one.key = var_1;
                 one.vals = tmp;
+                one.strong = strong;
                 affect_values.push_back(one);
 		        last_load_var_name_set.clear();
            }
         } 
         blockAffectMap[blockName] = affect_values;
-        //onstruct a order to access all blocks
-        blockOrder.push_back(blockName);
-        if(resultMap[blockName].size() != 0)
-            blockStatus[blockName] = 1;
-        else
-            blockStatus[blockName] = 0;
     }  
-    for (auto &BB: *F){
-        // Extract the last instruction in the stack (Terminator Instruction)
-        std::string blockName = getSimpleNodeLabel(&BB);
-        const TerminatorInst *TInst = (&BB)->getTerminator();
-        
-        // Extract the number of successors the terminator instructor has
-	    int NSucc = TInst->getNumSuccessors();
-        for (int i = 0;  i < NSucc; ++i) {
-            BasicBlock *Succ = TInst->getSuccessor(i);
-            std::string succBlockName = getSimpleNodeLabel(Succ);
-            previousBlockMap[succBlockName].insert(blockName);
-
-    	}	
-            
-    }
-        
-     while(true){
-         int blockChanged = 0;
-         for(std::list<std::string>::iterator ite = blockOrder.begin();ite != blockOrder.end();ite++){
-             std::string name = *ite;
-             std::set<std::string> parentNodes = previousBlockMap[name];
-             std::set<std::string> original_result = std::set<std::string>();
-             original_result.insert(resultMap[name].begin(),resultMap[name].end());
-             for(std::set<std::string>::iterator parentIter = parentNodes.begin();parentIter != parentNodes.end();parentIter++){
-                std::string parentName = *parentIter;
-                resultMap[name].insert(resultMap[parentName].begin(),resultMap[parentName].end());
-             }
-             for(std::vector<AffectItem>::iterator itemIter = blockAffectMap[name].begin(); itemIter != blockAffectMap[name].end(); itemIter++){
-                    std::string storeVar = (*itemIter).key;
-                    std::set<std::string> loadVars =  (*itemIter).vals;
-                    
-                    if(resultMap[name].find(storeVar) == resultMap[name].end() ){
-                        for(std::set<std::string>::iterator item = loadVars.begin(); item != loadVars.end();item++){
-                            if(resultMap[name].find(*item) != resultMap[name].end()){
-                                resultMap[name].insert(storeVar);
-                                break;
-                            }
-                        }
-                        
-		            }
-                    // if the taint variable were assign a untaint variable or constant, need to remove this
-                    else {
-                        bool remove = true;
-                        for(std::set<std::string>::iterator item = loadVars.begin(); item != loadVars.end();item++){
-                            if(resultMap[name].find(*item) != resultMap[name].end()){
-                                remove = false;
-                                break;
-                            }
-                        }
-                        if(remove){
-                            resultMap[name].erase(storeVar);
-                        }
-                        
-                    }
-	        }
-             std::map<std::set<std::string>,int> tmp;
-             tmp[original_result] = 1;
-             if(tmp.find(resultMap[name]) == tmp.end()){
-                 blockStatus[name] = 1;
-                 blockChanged++;
-             }else{
-                 blockStatus[name] = 0;
-             }
-         }
-         if(blockChanged == 0){
-             break;
-         }
-
-     }
-    
-	std::map<std::string,std::set<std::string>>::iterator ite;
-        for(ite = resultMap.begin(); ite != resultMap.end(); ite++) {
-        std::cout << "Block name:"<< ite->first << std::endl;
-        std::cout << "taint varabile have: ";
-           std::set<std::string>::iterator siter;
-           for( siter = ite->second.begin();siter != ite->second.end(); siter++){
-           std::cout << *siter << " ";
-           }
-           std::cout << std::endl;
+    initPhase.stop();
+
+    // Reachability: taint only moves along the store items, from the
+    // locations a store reads to the one it writes, so without a path from
+    // a source to the sink in that graph the sink is clean. Otherwise only
+    // the locations on such a path matter to the sink, and the fixpoint
+    // runs over their items alone.
+    std::set<std::string> relevant;
+    if (reach != NULL){
+        StatsPhase searchPhase(stats, "search");
+        std::map<std::string,std::set<std::string>> flowsTo, flowsFrom;
+        for (auto block = blockAffectMap.begin(); block != blockAffectMap.end(); block++){
+            for (auto item = block->second.begin(); item != block->second.end(); item++){
+                for (auto val = item->vals.begin(); val != item->vals.end(); val++){
+                    flowsTo[*val].insert(item->key);
+                    flowsFrom[item->key].insert(*val);
+                }
+            }
         }
+        std::set<std::string> sources;
+        for (auto block = resultMap.begin(); block != resultMap.end(); block++)
+            sources.insert(block->second.begin(), block->second.end());
+        if (sinkLocation.empty() || sources.empty()){
+            reach->tainted = false;
+            reach->reason = sinkLocation.empty() ? "no sink variable" : "no source variable";
+            return;
+        }
+        if (!findDependencePath(sources, sinkLocation, flowsTo, flowsFrom, reach->bidirectional)){
+            reach->tainted = false;
+            reach->reason = "no dependence path from source to sink";
+            return;
+        }
+        std::set<std::string> forward = dependenceClosure(sources, flowsTo);
+        std::set<std::string> backward = dependenceClosure(std::set<std::string>(&sinkLocation, &sinkLocation + 1), flowsFrom);
+        std::set_intersection(forward.begin(), forward.end(), backward.begin(), backward.end(), std::inserter(relevant, relevant.end()));
+        stats.set("relevant_locations", relevant.size());
+    }
+    // Intern every location and reduce each block's items to one summary
+    LocationTable locations;
+    for (auto block = resultMap.begin(); block != resultMap.end(); block++){
+        for (auto seed = block->second.begin(); seed != block->second.end(); seed++)
+            locations.intern(*seed);
+    }
+    for (auto block = blockAffectMap.begin(); block != blockAffectMap.end(); block++){
+        for (auto item = block->second.begin(); item != block->second.end(); item++){
+            locations.intern(item->key);
+            for (auto val = item->vals.begin(); val != item->vals.end(); val++)
+                locations.intern(*val);
+        }
+    }
+    if (reach != NULL || (provenance != NULL && !sinkLocation.empty()))
+        locations.intern(sinkLocation);
+    unsigned numLocations = locations.names.size();
+    std::vector<TransferSummary> summaries(G.size(), TransferSummary(numLocations));
+    std::vector<BitVector> taint(G.size(), BitVector(numLocations));
+    for (unsigned b = 0; b < G.size(); b++){
+        const std::vector<AffectItem> &items = blockAffectMap[G.labels[b]];
+        for (auto item = items.begin(); item != items.end(); item++){
+            if (reach != NULL && !relevant.count(item->key))
+                continue;
+            summaries[b] = summaries[b].then(TransferSummary::fromItem(*item, locations));
+        }
+        const std::set<std::string> &seeds = resultMap[G.labels[b]];
+        for (auto seed = seeds.begin(); seed != seeds.end(); seed++)
+            taint[b].set(locations.ids[*seed]);
+    }
+    unsigned sinkId = !sinkLocation.empty() && locations.ids.count(sinkLocation) ? locations.ids[sinkLocation] : 0;
+    if (provenance != NULL){
+        provenance->numLocations = numLocations;
+        provenance->parent.assign(G.size() * numLocations, TaintProvenance::NONE);
+        provenance->blocks = G.labels;
+        provenance->locations = locations.names;
+        provenance->hasSink = !sinkLocation.empty();
+        provenance->sinkId = sinkId;
+        // the sources are their own parents
+        for (unsigned b = 0; b < G.size(); b++){
+            for (int id = taint[b].find_first(); id != -1; id = taint[b].find_next(id))
+                provenance->parent[b * numLocations + id] = b * numLocations + id;
+        }
+    }
+
+    if (labelMap != NULL){
+        solveLabels(G, summaries, locations, seedLabels, locationMembers, *labelMap);
+        stats.set("blocks", G.size());
+        stats.set("labels", taintSpec.labels.size());
+        return;
+    }
+
+    TaintProblem problem(G, summaries, taint, reach, sinkId, provenance);
+
+    StatsPhase fixpointPhase(stats, "fixpoint");
+    // The components of G are solved in topological order, so the
+    // predecessors outside a component are final when it is entered. Each
+    // block also feeds on its own previous set, so even a block on no
+    // cycle is re-evaluated until it is stable.
+    dataflow::solveBySccs(problem, G);
+    fixpointPhase.stop();
+    if (reach != NULL){
+        if (!problem.decided){
+            reach->tainted = false;
+            reach->reason = "sink clean at the fixpoint";
+            for(unsigned b = 0; b < G.size() && !reach->tainted; b++){
+                if (taint[b].test(sinkId)){
+                    reach->tainted = true;
+                    reach->reason = "sink tainted in block " + G.labels[b] + " at the fixpoint";
+                }
+            }
+        }
+        return;
+    }
     
-    
-    return 0;
+    taintMap.clear();
+    for(unsigned b = 0; b < G.size(); b++) {
+        std::set<std::string> &taintVars = taintMap[G.labels[b]];
+        for(int id = taint[b].find_first(); id != -1; id = taint[b].find_next(id)){
+            const std::string &location = locations.names[id];
+            if(locationMembers.count(location))
+                taintVars.insert(locationMembers[location].begin(),locationMembers[location].end());
+            else
+                taintVars.insert(location);
+        }
+    }
+    stats.set("blocks", G.size());
+    stats.set("points_to_nodes", PT.numNodes());
+}
+
+// Whether a location in sources reaches sink along flowsTo. The
+// bidirectional search grows the smaller of a forward frontier from the
+// sources and a backward one (along flowsFrom) from the sink, one layer at
+// a time, and stops when they meet or either runs out.
+bool findDependencePath(const std::set<std::string> &sources, const std::string &sink, std::map<std::string,std::set<std::string>> &flowsTo, std::map<std::string,std::set<std::string>> &flowsFrom, bool bidirectional){
+    std::set<std::string> seenForward(sources), seenBackward;
+    std::vector<std::string> forward(sources.begin(), sources.end()), backward;
+    if (bidirectional){
+        seenBackward.insert(sink);
+        backward.push_back(sink);
+    }
+    if (seenForward.count(sink))
+        return true;
+    while (!forward.empty() && (!bidirectional || !backward.empty())){
+        bool growForward = !bidirectional || forward.size() <= backward.size();
+        std::vector<std::string> &frontier = growForward ? forward : backward;
+        std::set<std::string> &seen = growForward ? seenForward : seenBackward;
+        std::set<std::string> &other = growForward ? seenBackward : seenForward;
+        std::map<std::string,std::set<std::string>> &edges = growForward ? flowsTo : flowsFrom;
+        std::vector<std::string> next;
+        for (size_t i = 0; i < frontier.size(); i++){
+            std::set<std::string> &targets = edges[frontier[i]];
+            for (auto target = targets.begin(); target != targets.end(); target++){
+                STATS_COUNT(stats, "dependence_edges");
+                if (!seen.insert(*target).second)
+                    continue;
+                if (bidirectional ? other.count(*target) != 0 : *target == sink)
+                    return true;
+                next.push_back(*target);
+            }
+        }
+        frontier.swap(next);
+    }
+    return false;
+}
+
+// Every location reachable from start along edges
+std::set<std::string> dependenceClosure(const std::set<std::string> &start, std::map<std::string,std::set<std::string>> &edges){
+    std::set<std::string> seen(start);
+    std::vector<std::string> pending(start.begin(), start.end());
+    while (!pending.empty()){
+        std::set<std::string> &targets = edges[pending.back()];
+        pending.pop_back();
+        for (auto target = targets.begin(); target != targets.end(); target++){
+            if (seen.insert(*target).second)
+                pending.push_back(*target);
+        }
+    }
+    return seen;
+}
+
+// Read a spec (see TaintSpec) from path into spec; false, after reporting
+// the line, when it is malformed
+bool parseTaintSpec(const char *path, TaintSpec &spec){
+    std::ifstream in(path);
+    if (!in){
+        fprintf(stderr, "error: cannot read taint spec \"%s\"\n", path);
+        return false;
+    }
+    TaintSpec parsed;
+    parsed.labels.clear();
+    parsed.sources.clear();
+    parsed.sinks.clear();
+    parsed.multiLabel = true;
+    std::map<std::string,unsigned> labelIds;
+    // sinks name labels a later line may define
+    std::vector<std::pair<unsigned,std::vector<std::string>>> sinkLines;
+    std::string line;
+    for (unsigned lineNo = 1; std::getline(in, line); lineNo++){
+        std::istringstream words(line.substr(0, line.find('#')));
+        std::vector<std::string> args;
+        std::string word;
+        while (words >> word)
+            args.push_back(word);
+        if (args.empty())
+            continue;
+        if (args[0] == "source" && args.size() >= 3){
+            if (!labelIds.count(args[1])){
+                labelIds[args[1]] = parsed.labels.size();
+                parsed.labels.push_back(args[1]);
+            }
+            for (size_t i = 2; i < args.size(); i++){
+                std::vector<unsigned> &labels = parsed.sources[args[i]];
+                if (std::find(labels.begin(), labels.end(), labelIds[args[1]]) == labels.end())
+                    labels.push_back(labelIds[args[1]]);
+            }
+        }
+        else if (args[0] == "sink" && args.size() >= 2)
+            sinkLines.push_back(std::make_pair(lineNo, args));
+        else{
+            fprintf(stderr, "error: %s:%u: expected \"source LABEL VAR...\" or \"sink VAR [LABEL...]\"\n", path, lineNo);
+            return false;
+        }
+    }
+    if (parsed.labels.empty()){
+        fprintf(stderr, "error: %s: no source\n", path);
+        return false;
+    }
+    for (size_t i = 0; i < sinkLines.size(); i++){
+        const std::vector<std::string> &args = sinkLines[i].second;
+        std::vector<unsigned> &labels = parsed.sinks[args[1]];
+        for (unsigned l = 0; args.size() == 2 && l < parsed.labels.size(); l++)
+            labels.push_back(l);
+        for (size_t a = 2; a < args.size(); a++){
+            if (!labelIds.count(args[a])){
+                fprintf(stderr, "error: %s:%u: unknown label \"%s\"\n", path, sinkLines[i].first, args[a].c_str());
+                return false;
+            }
+            labels.push_back(labelIds[args[a]]);
+        }
+        std::sort(labels.begin(), labels.end());
+        labels.erase(std::unique(labels.begin(), labels.end()), labels.end());
+    }
+    spec = parsed;
+    return true;
+}
+
+// Daemon mode: besides analyze/invalidate/shutdown (see Daemon.h) the
+// daemon answers
+//
+//     taint FILE BLOCK   ->   ok VAR...
+typedef std::map<std::string,std::set<std::string>> TaintResult;
+
+bool solveFile(const std::string &path, TaintResult &result){
+    SMDiagnostic Err;
+    Module *M = loadModule(path, Err, getGlobalContext());
+    if (M == nullptr)
+        return false;
+    Function *F = M->getFunction("main");
+    if (F == nullptr || F->empty()){
+        delete M;
+        return false;
+    }
+    solveTaint(F, result);
+    delete M;
+    return true;
+}
+
+FileCache<TaintResult> taintCache(solveFile);
+
+std::string handleRequest(const std::vector<std::string> &words){
+    if (words[0] == "analyze" && words.size() == 2){
+        const TaintResult *result = taintCache.get(words[1]);
+        if (result == nullptr)
+            return "error cannot analyze " + words[1];
+        return "ok " + std::to_string(result->size()) + " blocks";
+    }
+    if (words[0] == "invalidate" && words.size() == 2){
+        taintCache.invalidate(words[1]);
+        return "ok";
+    }
+    if (words[0] == "taint" && words.size() == 3){
+        const TaintResult *result = taintCache.get(words[1]);
+        if (result == nullptr)
+            return "error cannot analyze " + words[1];
+        TaintResult::const_iterator block = result->find(words[2]);
+        if (block == result->end())
+            return "error no block " + words[2];
+        std::string response = "ok";
+        for (std::set<std::string>::const_iterator var = block->second.begin(); var != block->second.end(); var++)
+            response += " " + *var;
+        return response;
+    }
+    return "error unknown request " + words[0];
 }
 
 std::string getSimpleVarName(const Instruction* Ins){
@@ -200,8 +1002,33 @@ if(NULL != Ins){
     return "";
 }
 
+// Name of the abstract location a load or store address refers to: the
+// smallest name among the allocas and globals in its points-to class, or
+// "" when the class holds none. Every variable in the class is recorded
+// under that name in locationMembers.
+std::string getLocationName(PointsToGraph &PT, Value *address, std::map<std::string,std::set<std::string>> &locationMembers){
+    unsigned cls = PT.pointee(address);
+    if(cls == PointsToGraph::NONE)
+        return "";
+    std::set<std::string> members;
+    const std::vector<const Value*> &objects = PT.objectsIn(cls);
+    for(unsigned i = 0; i < objects.size(); i++){
+        if(const Instruction *object = dyn_cast<Instruction>(objects[i]))
+            members.insert(getSimpleVarName(object));
+        else
+            members.insert(objects[i]->getName().str());
+    }
+    if(members.empty())
+        return "";
+    locationMembers[*members.begin()] = members;
+    return *members.begin();
+}
+
 // Printing Basic Block Label 
 std::string getSimpleNodeLabel(const BasicBlock *Node) {
+    std::map<const BasicBlock*, std::string>::const_iterator renamed = prePassLabels().find(Node);
+    if (renamed != prePassLabels().end())
+        return renamed->second;
     if (!Node->getName().empty())
         return Node->getName().str();
     std::string Str;
@@ -209,3 +1036,46 @@ std::string getSimpleNodeLabel(const BasicBlock *Node) {
     Node->printAsOperand(OS, false);
     return OS.str();
 }
+
+#ifdef CS5218_PLUGIN
+// Pass plugin (see PassPlugin.h): the taint of main, written to
+// <input>.taint or -cs5218-taint-output
+namespace {
+cl::opt<std::string> TaintOutput("cs5218-taint-output", cl::desc("file the cs5218-taint report is written to"), cl::value_desc("file"));
+cl::opt<std::string> TaintSpecFile("cs5218-taint-spec", cl::desc("sources, sinks and labels of cs5218-taint (as --taint-spec)"), cl::value_desc("file"));
+
+struct TaintPass : public FunctionPass {
+    static char ID;
+    TaintPass() : FunctionPass(ID) {}
+
+    bool runOnFunction(Function &F) override {
+        if (F.getName() != "main" || F.empty())
+            return false;
+        if (!TaintSpecFile.empty() && !parseTaintSpec(TaintSpecFile.c_str(), taintSpec))
+            return false;
+        std::map<std::string,std::set<std::string>> taintMap;
+        std::ostringstream report;
+        if (taintSpec.multiLabel){
+            LabelTaintMap labelMap;
+            solveTaint(&F, taintMap, NULL, &labelMap);
+            printLabelTaint(report, labelMap);
+        }else{
+            solveTaint(&F, taintMap);
+            printTaint(report, taintMap);
+        }
+        writePluginOutput(pluginOutputPath(*F.getParent(), TaintOutput, ".taint"), report.str());
+        return false;
+    }
+    void getAnalysisUsage(AnalysisUsage &AU) const override {
+        AU.setPreservesAll();
+    }
+};
+}
+
+char TaintPass::ID = 0;
+static RegisterPass<TaintPass> RegisterTaint("cs5218-taint", "CS5218 taint analysis of main", false, true);
+static void addTaintPass(const PassManagerBuilder &, legacy::PassManagerBase &PM){
+    PM.add(new TaintPass());
+}
+static RegisterStandardPasses RegisterTaintInClang(PassManagerBuilder::EP_EarlyAsPossible, addTaintPass);
+#endif
@@ -0,0 +1,8 @@
+int main(){
+     int a,b,sink,source;
+     int *p;
+     p = &a;
+     *p = source;
+     b = a;
+     sink = b;
+}
@@ -1,4 +1,6 @@
 #include <cstdio>
+#include <cstring>
+#include <cstdint>
 #include <iostream>
 #include <set>
 #include <map>
@@ -6,6 +8,7 @@
 #include <string>
 #include <algorithm>
 #include <utility>
+#include <vector>
 
 #include "llvm/IR/LLVMContext.h"
 #include "llvm/IR/Module.h"
@@ -14,101 +17,52 @@
 #include "llvm/IR/BasicBlock.h"
 #include "llvm/IR/CFG.h"
 #include "llvm/IR/Constants.h"
+#include "llvm/IR/LegacyPassManager.h"
 #include "llvm/IRReader/IRReader.h"
+#include "llvm/Pass.h"
+#include "llvm/Support/CommandLine.h"
 #include "llvm/Support/SourceMgr.h"
 #include "llvm/Support/raw_ostream.h"
+#include "llvm/Transforms/IPO/PassManagerBuilder.h"
+#include "llvm/ADT/DenseSet.h"
 #include "llvm/ADT/DepthFirstIterator.h"
 #include "llvm/ADT/GraphTraits.h"
 
-using namespace llvm;
-const static int POS_INF = 1000;
-const static int NEG_INF = -1000;
-
-class Interval
-{
-  public:
-	int lower;
-	int upper;
-	bool empty;
-	Interval() { empty = true; }
-	Interval(int lower, int upper)
-	{
-		if (lower <= NEG_INF)
-			this->lower = NEG_INF;
-		else if (lower >= POS_INF)
-			this->lower = POS_INF;
-		else
-			this->lower = lower;
-
-		if (upper >= POS_INF)
-			this->upper = POS_INF;
-		else if (upper <= NEG_INF)
-			this->upper = NEG_INF;
-		else
-			this->upper = upper;
-		empty = false;
-	}
-	bool isEmpty()
-	{
-		return this->empty;
-	}
-	int getUpper()
-	{
-		return this->upper;
-	}
-	int getLower()
-	{
-		return this->lower;
-	}
-	void setLower(int lower)
-	{
-		if (lower <= NEG_INF)
-			this->lower = NEG_INF;
-		else if (lower >= POS_INF)
-			this->lower = POS_INF;
-		else
-			this->lower = lower;
-	}
-	void setUpper(int upper)
-	{
-		if (upper >= POS_INF)
-			this->upper = POS_INF;
-		else if (upper <= NEG_INF)
-			this->upper = NEG_INF;
-		else
-			this->upper = upper;
-	}
-	bool operator==(const Interval &a)
-	{
-		return (a.lower == this->lower && a.upper == this->upper);
-	}
-	bool operator!=(const Interval &a)
-	{
-		return (a.lower != this->lower || a.upper != this->upper);
-	}
-	std::string toString()
-	{
-		return "[ " + (this->getLower() == NEG_INF ? "NEG_INF" : std::to_string(this->getLower())) + " , " +
-			   (this->getUpper() == POS_INF ? "POS_INF" : std::to_string(this->getUpper())) + " ]";
-	}
-};
-
-typedef std::map<std::string, Interval> BBANALYSIS;
-std::map<std::string, BBANALYSIS> analysisMap;
+#include "../../common/AnalysisStats.h"
+#include "../../common/BlockGraph.h"
+#include "../../common/ConvergenceProfile.h"
+#include "../../common/Dataflow.h"
+#include "../../common/Daemon.h"
+#include "../../common/FlatIntervalState.h"
+#include "../../common/IntervalAnalysis.h"
+#include "../../common/ModuleLoader.h"
+#include "../../common/PassPlugin.h"
+#include "../../common/PrePass.h"
+#include "../../common/Trace.h"
 
-std::set<std::string> activeBlocks;
+using namespace llvm;
+AnalysisStats stats;
+TraceRecorder tracer;
+ConvergenceProfile profile;
+// reused between joins, so its arrays are allocated once
+FlatIntervalState conditional;
+
+// While sliceActive, only the blocks and instructions in the slice of a
+// demand-driven query are evaluated (see queryInterval)
+bool sliceActive = false;
+std::vector<char> sliceBlocks;
+llvm::DenseSet<const llvm::Instruction *> sliceInstructions;
+
+// --accelerate: while a counting loop is solved (see solveCountingLoop),
+// the variables it counts with are pinned to loopPins at the input of
+// pinnedHeader; afterwards the edges marked in exitEdgeOverride leave the
+// header from its state on the final visit, kept in loopExitStates
+bool accelerateLoops = false;
+unsigned pinnedHeader = BlockGraph::NOT_REACHABLE;
+FlatIntervalState loopPins;
+std::vector<FlatIntervalState> loopExitStates;
+std::vector<char> exitEdgeOverride;
 
-bool CheckBbanalysisEquals(BBANALYSIS a, BBANALYSIS b)
-{
-	if (a.size() != b.size())
-		return false;
-	for (auto it = a.begin(); it != a.end(); ++it)
-	{
-		if (b.find(it->first) == b.end() || b[it->first] != it->second)
-			return false;
-	}
-	return true;
-}
 std::string getSimpleVarName(const Instruction *Ins)
 {
 	if (NULL != Ins && !Ins->getName().empty())
@@ -125,6 +79,9 @@ std::string getSimpleVarName(const Instruction *Ins)
 }
 std::string getSimpleNodeLabel(const BasicBlock *Node)
 {
+	std::map<const BasicBlock *, std::string>::const_iterator renamed = prePassLabels().find(Node);
+	if (renamed != prePassLabels().end())
+		return renamed->second;
 	if (!Node->getName().empty())
 		return Node->getName().str();
 	std::string Str;
@@ -132,982 +89,1142 @@ std::string getSimpleNodeLabel(const BasicBlock *Node)
 	Node->printAsOperand(OS, false);
 	return OS.str();
 }
-//======================================================================
-// Check fixpoint reached
-//======================================================================
-// F used for add active block
-bool fixPointReached(std::map<std::string, BBANALYSIS> oldAnalysisMap, Function *F)
+// Overwrite the variables of state that pins holds with their pinned
+// intervals; variables state does not hold stay absent
+void pinVariables(FlatIntervalState &state, const FlatIntervalState &pins)
 {
-	bool result = true;
-	if (oldAnalysisMap.empty())
-		result = false;
-	for (auto it = analysisMap.begin(); it != analysisMap.end(); ++it)
+	for (unsigned id = 0; id < pins.size(); id++)
 	{
-
-		if (!CheckBbanalysisEquals(oldAnalysisMap[it->first], it->second))
-		{
-			result = false;
-			activeBlocks.insert(it->first);
-			// add this block successor to the activeblock
-			for (auto &BB : *F)
-			{
-				std::string blockName = getSimpleNodeLabel(&BB);
-				if (!it->first.compare(blockName))
-				{
-					const TerminatorInst *TInst = BB.getTerminator();
-					// Extract the number of successors the terminator instructor has
-					int NSucc = TInst->getNumSuccessors();
-					for (int i = 0; i < NSucc; ++i)
-					{
-						BasicBlock *Succ = TInst->getSuccessor(i);
-						activeBlocks.insert(getSimpleNodeLabel(Succ));
-					}
-				}
-			}
-		}
+		if (pins.has(id) && state.has(id))
+			state.set(id, pins.lower[id], pins.upper[id]);
 	}
-	return result;
 }
 
-// Performs set union
-Interval union_intervals(Interval A, Interval B)
+//======================================================================
+// Comparison refinement rules
+//======================================================================
+// Every icmp predicate, taken on either edge of its branch, states one of
+// four relations between its operands a and b, possibly with a and b
+// swapped:
+//
+//     LT   a <  b    a.hi <= b.hi - 1,  b.lo >= a.lo + 1
+//     LE   a <= b    a.hi <= b.hi,      b.lo >= a.lo
+//     EQ   a == b    LE in both directions
+//     NE   a != b    a bound equal to the other side's single value is
+//                    stepped past it
+//
+// compareRules[] holds that relation for each (predicate, edge) pair, so
+// one routine, refineBounds(), refines var-const, const-var and var-var
+// compares, and decides const-const ones. Unsigned predicates order
+// operands like the signed ones only while both are non-negative; when an
+// operand may be negative the edge is left unrefined.
+struct CompareRule
 {
-	return Interval(std::min(A.getLower(), B.getLower()), std::max(A.getUpper(), B.getUpper()));
-}
+	bool swap;	   // the relation reads "b R a"
+	bool le;	   // a <= b - offset
+	bool ge;	   // a >= b
+	bool ne;	   // a != b
+	int offset;	   // 1 for LT, else 0
+	bool isUnsigned;
+};
 
-// Performs analysis union
-BBANALYSIS union_analysis(BBANALYSIS dest, BBANALYSIS source)
-{
-	for (auto it = source.begin(); it != source.end(); ++it)
-	{
-		if (dest.find(it->first) == dest.end())
-			dest[it->first] = Interval(it->second.getLower(), it->second.getUpper());
-		else
-		{
-			dest[it->first] = union_intervals(dest[it->first], it->second);
-		}
-	}
+// indexed by (predicate - ICMP_EQ) * 2 + (true edge ? 1 : 0)
+const CompareRule compareRules[] = {
+	// swap   le     ge     ne    off  unsigned
+	{false, false, false, true, 0, false}, // eq, false edge: a != b
+	{false, true, true, false, 0, false},  // eq, true edge:  a == b
+	{false, true, true, false, 0, false},  // ne, false edge: a == b
+	{false, false, false, true, 0, false}, // ne, true edge:  a != b
+	{false, true, false, false, 0, true},  // ugt, false edge: a <= b
+	{true, true, false, false, 1, true},   // ugt, true edge:  b < a
+	{false, true, false, false, 1, true},  // uge, false edge: a < b
+	{true, true, false, false, 0, true},   // uge, true edge:  b <= a
+	{true, true, false, false, 0, true},   // ult, false edge: b <= a
+	{false, true, false, false, 1, true},  // ult, true edge:  a < b
+	{true, true, false, false, 1, true},   // ule, false edge: b < a
+	{false, true, false, false, 0, true},  // ule, true edge:  a <= b
+	{false, true, false, false, 0, false}, // sgt, false edge: a <= b
+	{true, true, false, false, 1, false},  // sgt, true edge:  b < a
+	{false, true, false, false, 1, false}, // sge, false edge: a < b
+	{true, true, false, false, 0, false},  // sge, true edge:  b <= a
+	{true, true, false, false, 0, false},  // slt, false edge: b <= a
+	{false, true, false, false, 1, false}, // slt, true edge:  a < b
+	{true, true, false, false, 1, false},  // sle, false edge: b < a
+	{false, true, false, false, 0, false}  // sle, true edge:  a <= b
+};
 
-	return dest;
+const CompareRule *getCompareRule(llvm::CmpInst::Predicate pred, bool flag)
+{
+	if (pred < llvm::CmpInst::FIRST_ICMP_PREDICATE || pred > llvm::CmpInst::LAST_ICMP_PREDICATE)
+		return NULL;
+	return &compareRules[(pred - llvm::CmpInst::ICMP_EQ) * 2 + (flag ? 1 : 0)];
 }
 
-//======================================================================
-// update Basic Block Analysis
-//======================================================================
-// Processing Alloca Instruction
-void processAlloca(llvm::Instruction *I, BBANALYSIS *analysis)
+// Interval bounds as plain numbers: constants are not clamped to
+// [NEG_INF, POS_INF] before they are compared against, and a variable's
+// infinite bound is +/- UNBOUNDED, so that no offset or comparison treats
+// the sentinel as a value
+struct Bounds
 {
-	AllocaInst *allocInst = dyn_cast<AllocaInst>(I);
-	(*analysis)[getSimpleVarName(allocInst)] = Interval(NEG_INF, POS_INF);
+	int64_t lo;
+	int64_t hi;
+	Bounds(int64_t lo, int64_t hi) : lo(lo), hi(hi) {}
+};
+const static int64_t UNBOUNDED = int64_t(1) << 62;
+
+// The bounds of variable id in state; only a lower NEG_INF and an upper
+// POS_INF are unbounded, a lower POS_INF (upper NEG_INF) still bounds it
+Bounds variableBounds(const FlatIntervalState &state, unsigned id)
+{
+	return Bounds(state.lower[id] == NEG_INF ? -UNBOUNDED : state.lower[id],
+				  state.upper[id] == POS_INF ? UNBOUNDED : state.upper[id]);
 }
 
-// Processing Store Instruction
-void processStore(llvm::Instruction *I, BBANALYSIS *analysis)
+// Narrows a and b to the values satisfying "a R b"; false when none do.
+// The caller has already applied rule.swap.
+bool refineBounds(const CompareRule &rule, Bounds &a, Bounds &b)
 {
-	Value *op1 = I->getOperand(0);
-	Value *op2 = I->getOperand(1);
-	if (isa<ConstantInt>(op1))
+	if (rule.isUnsigned && (a.lo < 0 || b.lo < 0))
+		return true;
+	if (rule.le)
 	{
-		llvm::ConstantInt *CI = dyn_cast<ConstantInt>(op1);
-		int64_t op1Int = CI->getSExtValue();
-		std::string name = getSimpleVarName(dyn_cast<Instruction>(op2));
-		if ((*analysis).find(name) != (*analysis).end())
-			(*analysis)[name] = Interval(op1Int, op1Int);
+		a.hi = std::min(a.hi, b.hi - rule.offset);
+		b.lo = std::max(b.lo, a.lo + rule.offset);
 	}
-	else
+	if (rule.ge)
+	{
+		b.hi = std::min(b.hi, a.hi);
+		a.lo = std::max(a.lo, b.lo);
+	}
+	if (rule.ne)
 	{
-		std::string name1 = getSimpleVarName(dyn_cast<Instruction>(op1));
-		std::string name2 = getSimpleVarName(dyn_cast<Instruction>(op2));
-		if ((*analysis).find(name1) != (*analysis).end())
-			(*analysis)[name2] = (*analysis)[name1];
+		if (b.lo == b.hi)
+		{
+			if (a.lo == b.lo)
+				a.lo++;
+			if (a.hi == b.lo)
+				a.hi--;
+		}
+		if (a.lo == a.hi)
+		{
+			if (b.lo == a.lo)
+				b.lo++;
+			if (b.hi == a.lo)
+				b.hi--;
+		}
 	}
+	return a.lo <= a.hi && b.lo <= b.hi;
 }
 
-// Processing Load Instruction
-void processLoad(llvm::Instruction *I, BBANALYSIS *analysis)
+// "c1 R c2" for two constants, in the predicate's signedness
+bool compareHolds(const CompareRule &rule, int64_t c1, int64_t c2)
 {
-	Value *op1 = I->getOperand(0);
-	LoadInst *load = dyn_cast<LoadInst>(I);
-	std::string name = getSimpleVarName(load);
-	if (isa<ConstantInt>(op1))
+	if (rule.swap)
+		std::swap(c1, c2);
+	if (rule.isUnsigned)
 	{
-		llvm::ConstantInt *CI = dyn_cast<ConstantInt>(op1);
-		int64_t op1Int = CI->getSExtValue();
-		(*analysis)[name] = Interval(op1Int, op1Int);
-	}
-	else
-	{
-		std::string name1 = getSimpleVarName(dyn_cast<Instruction>(op1));
-		if ((*analysis).find(name1) != (*analysis).end())
-			(*analysis)[name] = (*analysis)[name1];
+		uint64_t a = c1, b = c2;
+		return (!rule.le || (rule.offset ? a < b : a <= b)) && (!rule.ge || a >= b) && (!rule.ne || a != b);
 	}
+	return (!rule.le || (rule.offset ? c1 < c2 : c1 <= c2)) && (!rule.ge || c1 >= c2) && (!rule.ne || c1 != c2);
 }
-Interval extractInterval(Value *op, BBANALYSIS *analysis)
+
+//======================================================================
+// Branch edge refinement table
+//======================================================================
+// The refinement a conditional branch applies along one CFG edge only
+// depends on the IR, so it is decoded once per edge before the fixpoint
+// loop: the operand shape, the predicate, the constants, the variables the
+// compared loads read from (by name, and by their id in the analysis), and
+// whether the edge is the true or the false successor.
+enum EdgeCondKind
 {
-	if (isa<ConstantInt>(op))
-	{
-		llvm::ConstantInt *CI = dyn_cast<ConstantInt>(op);
-		int64_t op1Int = CI->getSExtValue();
-		return Interval(op1Int, op1Int);
-	}
-	else
-	{
-		std::string name = getSimpleVarName(dyn_cast<Instruction>(op));
-		if ((*analysis).find(name) != (*analysis).end())
-			return (*analysis)[name];
-		else
-			return Interval();
-	}
+	EDGE_NONE,		  // unconditional, or a condition we cannot refine on
+	EDGE_CONST_CONST, // icmp c1, c2
+	EDGE_VAR_CONST,	  // icmp (load var), c
+	EDGE_CONST_VAR,	  // icmp c, (load var)
+	EDGE_VAR_VAR	  // icmp (load var1), (load var2)
+};
+
+struct EdgeRefinement
+{
+	EdgeCondKind kind;
+	llvm::CmpInst::Predicate pred;
+	int64_t const1;
+	int64_t const2;
+	std::string varName1;
+	std::string varName2;
+	unsigned var1;
+	unsigned var2;
+	bool flag;
+	const CompareRule *rule;
+	EdgeRefinement() : kind(EDGE_NONE), pred(llvm::CmpInst::ICMP_EQ), const1(0), const2(0), var1(VariableTable::NOT_FOUND), var2(VariableTable::NOT_FOUND), flag(false), rule(NULL) {}
+};
+
+// indexed by BlockGraph pred slot
+std::vector<EdgeRefinement> edgeTable;
+
+// Name of the variable a compare operand was loaded from, or "" when the
+// operand is not a load of an instruction-defined address
+std::string getLoadedVarName(Value *op)
+{
+	LoadInst *load = dyn_cast<LoadInst>(op);
+	if (load == NULL || !isa<Instruction>(load->getPointerOperand()))
+		return "";
+	return getSimpleVarName(dyn_cast<Instruction>(load->getPointerOperand()));
 }
-void processAdd(llvm::Instruction *I, BBANALYSIS *analysis)
+
+EdgeRefinement decodeEdge(BasicBlock *predecessor, BasicBlock *BB)
 {
-	Value *op1 = I->getOperand(0);
-	Value *op2 = I->getOperand(1);
-	Interval one = extractInterval(op1, analysis);
-	Interval two = extractInterval(op2, analysis);
-	if (one.isEmpty() || two.isEmpty())
-		return;
-	std::string name = getSimpleVarName(I);
-	int lower = NEG_INF;
-	int upper = POS_INF;
-	if (one.getLower() != NEG_INF && two.getLower() != NEG_INF)
-	{
-		lower = one.getLower() + two.getLower();
-	}
-	if (one.getUpper() != POS_INF && two.getUpper() != POS_INF)
-	{
-		upper = one.getUpper() + two.getUpper();
-	}
-	(*analysis)[name] = Interval(lower, upper);
+	EdgeRefinement edge;
+	BranchInst *br = dyn_cast<BranchInst>(predecessor->getTerminator());
+	if (br == NULL || !br->isConditional())
+		return edge;
+	llvm::ICmpInst *cmp = dyn_cast<llvm::ICmpInst>(br->getCondition());
+	if (cmp == NULL)
+		return edge;
+
+	Value *op1 = cmp->getOperand(0);
+	Value *op2 = cmp->getOperand(1);
+	edge.pred = cmp->getPredicate();
+	if (BB == br->getOperand(2))
+		edge.flag = true;
+	if (BB == br->getOperand(1))
+		edge.flag = false;
+	edge.rule = getCompareRule(edge.pred, edge.flag);
+	if (edge.rule == NULL)
+		return edge;
+
+	// now need to consider 3 cases: const-const  const-var   var-var
+	std::string varName1 = getLoadedVarName(op1);
+	std::string varName2 = getLoadedVarName(op2);
+	if (isa<ConstantInt>(op1) && isa<ConstantInt>(op2))
+	{
+		edge.kind = EDGE_CONST_CONST;
+		edge.const1 = dyn_cast<ConstantInt>(op1)->getSExtValue();
+		edge.const2 = dyn_cast<ConstantInt>(op2)->getSExtValue();
+	}
+	else if (!varName1.empty() && isa<ConstantInt>(op2))
+	{
+		edge.kind = EDGE_VAR_CONST;
+		edge.varName1 = varName1;
+		edge.const2 = dyn_cast<ConstantInt>(op2)->getSExtValue();
+	}
+	else if (isa<ConstantInt>(op1) && !varName2.empty())
+	{
+		edge.kind = EDGE_CONST_VAR;
+		edge.const1 = dyn_cast<ConstantInt>(op1)->getSExtValue();
+		edge.varName2 = varName2;
+	}
+	else if (!varName1.empty() && !varName2.empty())
+	{
+		edge.kind = EDGE_VAR_VAR;
+		edge.varName1 = varName1;
+		edge.varName2 = varName2;
+	}
+	return edge;
 }
-void processSub(llvm::Instruction *I, BBANALYSIS *analysis)
+
+void buildEdgeTable(const BlockGraph &G, const VariableTable &variables)
 {
-	Value *op1 = I->getOperand(0);
-	Value *op2 = I->getOperand(1);
-	Interval one = extractInterval(op1, analysis);
-	Interval two = extractInterval(op2, analysis);
-	if (one.isEmpty() || two.isEmpty())
-		return;
-	std::string name = getSimpleVarName(I);
-	int lower = NEG_INF;
-	int upper = POS_INF;
-	if (one.getLower() != NEG_INF && two.getUpper() != POS_INF)
+	edgeTable.clear();
+	for (unsigned b = 0; b < G.size(); b++)
 	{
-		lower = one.getLower() - two.getUpper();
-	}
-	if (one.getUpper() != POS_INF && two.getLower() != NEG_INF)
-	{
-		upper = one.getUpper() - two.getLower();
+		for (const unsigned *pred = G.predBegin(b); pred != G.predEnd(b); ++pred)
+		{
+			EdgeRefinement edge = decodeEdge(G.blocks[*pred], G.blocks[b]);
+			if (!edge.varName1.empty())
+				edge.var1 = variables.lookup(edge.varName1);
+			if (!edge.varName2.empty())
+				edge.var2 = variables.lookup(edge.varName2);
+			edgeTable.push_back(edge);
+		}
 	}
-	(*analysis)[name] = Interval(lower, upper);
-}
-void processMul(llvm::Instruction *I, BBANALYSIS *analysis)
-{
-	Value *op1 = I->getOperand(0);
-	Value *op2 = I->getOperand(1);
-	Interval one = extractInterval(op1, analysis);
-	Interval two = extractInterval(op2, analysis);
-	if (one.isEmpty() || two.isEmpty())
-		return;
-	std::string name = getSimpleVarName(I);
-	std::vector<int> tmp;
-	tmp.push_back(one.getLower() * two.getLower());
-	tmp.push_back(one.getUpper() * two.getUpper());
-	tmp.push_back(one.getLower() * two.getUpper());
-	tmp.push_back(one.getUpper() * two.getLower());
-
-	(*analysis)[name] = Interval(*(std::min_element(tmp.begin(), tmp.end())), *(std::max_element(tmp.begin(), tmp.end())));
 }
 
-void processDiv(llvm::Instruction *I, BBANALYSIS *analysis)
+// Refines state along one edge. Only the compared variables are read and
+// written; when the edge is infeasible state becomes empty. A compare
+// against a variable the state does not hold refines nothing.
+void applyCond(FlatIntervalState &state, const EdgeRefinement &edge)
 {
-	Value *op1 = I->getOperand(0);
-	Value *op2 = I->getOperand(1);
-	Interval one = extractInterval(op1, analysis);
-	Interval two = extractInterval(op2, analysis);
-	if (one.isEmpty() || two.isEmpty())
+	if (edge.kind == EDGE_NONE)
 		return;
-	std::string name = getSimpleVarName(I);
-	if (two.getLower() == 0 && two.getUpper() == 0)
+	STATS_COUNT(stats, "applyCond");
+	if (edge.kind == EDGE_CONST_CONST)
 	{
-		(*analysis)[name] = Interval(NEG_INF, POS_INF);
+		if (!compareHolds(*edge.rule, edge.const1, edge.const2))
+			state.clear();
+		return;
 	}
-	std::vector<int> tmp;
-	if (two.getUpper() == 0)
+	unsigned id1 = edge.var1, id2 = edge.var2;
+	int64_t const1 = std::min(std::max(edge.const1, -UNBOUNDED), UNBOUNDED);
+	int64_t const2 = std::min(std::max(edge.const2, -UNBOUNDED), UNBOUNDED);
+	Bounds op1(const1, const1), op2(const2, const2);
+	if (!edge.varName1.empty())
 	{
-		tmp.push_back(one.getLower() * (-1));
-		tmp.push_back(one.getUpper() * (-1));
-		tmp.push_back(one.getLower() / two.getLower());
-		tmp.push_back(one.getUpper() / two.getLower());
+		if (!state.has(id1))
+			return;
+		op1 = variableBounds(state, id1);
 	}
-	else if (two.getLower() == 0)
+	if (!edge.varName2.empty())
 	{
-		tmp.push_back(one.getLower());
-		tmp.push_back(one.getUpper());
-		tmp.push_back(one.getLower() / two.getUpper());
-		tmp.push_back(one.getUpper() / two.getUpper());
+		if (!state.has(id2))
+			return;
+		op2 = variableBounds(state, id2);
 	}
-	else if (two.getUpper() > 0 and two.getLower() < 0)
+	bool feasible = edge.rule->swap ? refineBounds(*edge.rule, op2, op1) : refineBounds(*edge.rule, op1, op2);
+	if (!feasible)
 	{
-		tmp.push_back(one.getLower() * (-1));
-		tmp.push_back(one.getUpper() * (-1));
-		tmp.push_back(one.getLower() / two.getLower());
-		tmp.push_back(one.getUpper() / two.getLower());
-
-		tmp.push_back(one.getLower());
-		tmp.push_back(one.getUpper());
-		tmp.push_back(one.getLower() / two.getUpper());
-		tmp.push_back(one.getUpper() / two.getUpper());
+		state.clear();
+		return;
 	}
-	else
+	if (id1 != VariableTable::NOT_FOUND)
 	{
-		tmp.push_back(one.getLower() / two.getLower());
-		tmp.push_back(one.getUpper() / two.getLower());
-		tmp.push_back(one.getLower() / two.getUpper());
-		tmp.push_back(one.getUpper() / two.getUpper());
+		Interval refined((int)std::max<int64_t>(op1.lo, NEG_INF), (int)std::min<int64_t>(op1.hi, POS_INF));
+		state.set(id1, refined.getLower(), refined.getUpper());
+	}
+	if (id2 != VariableTable::NOT_FOUND)
+	{
+		Interval refined((int)std::max<int64_t>(op2.lo, NEG_INF), (int)std::min<int64_t>(op2.hi, POS_INF));
+		state.set(id2, refined.getLower(), refined.getUpper());
 	}
-	(*analysis)[name] = Interval(*(std::min_element(tmp.begin(), tmp.end())), *(std::max_element(tmp.begin(), tmp.end())));
 }
 
-void processRem(llvm::Instruction *I, BBANALYSIS *analysis)
+// The interval analysis (see IntervalAnalysis.h) with the edges of
+// conditional branches refined, demand-driven slices and counting loop
+// acceleration
+struct BranchIntervalProblem : IntervalProblem<BranchIntervalProblem>
 {
-	Value *op1 = I->getOperand(0);
-	Value *op2 = I->getOperand(1);
-	Interval one = extractInterval(op1, analysis);
-	Interval two = extractInterval(op2, analysis);
-	if (one.isEmpty() || two.isEmpty())
-		return;
-	std::string name = getSimpleVarName(I);
+	// every predecessor is gathered from the first round on
+	enum { startsActive = true };
 
-	if (one.getUpper() == POS_INF && two.getUpper() == POS_INF)
-	{
-		(*analysis)[name] = Interval(0, POS_INF);
-	}
-	else if (one.getUpper() == POS_INF)
-	{
-		(*analysis)[name] = Interval(0, two.getUpper() - 1);
-	}
-	else if (two.getUpper() == POS_INF)
+	BranchIntervalProblem() : IntervalProblem<BranchIntervalProblem>(::stats, ::tracer, ::profile) {}
+
+	// Join the stored state of an active predecessor into in; the
+	// edge's branch condition refines it first
+	void joinEdge(FlatIntervalState &in, unsigned from, unsigned slot)
 	{
-		(*analysis)[name] = Interval(0, one.getUpper());
+		if (!activeBlocks[from])
+			return;
+		// in this way, we need to merge all the predecessor information
+		spill.touch(blockStates, from);
+		conditional = exitEdgeOverride[slot] ? loopExitStates[from] : blockStates[from];
+		applyCond(conditional, edgeTable[slot]);
+		STATS_COUNT(stats, "join");
+		Lattice::join(in, conditional);
 	}
-	else if (one.getUpper() < two.getUpper())
+	void refineInput(unsigned b, FlatIntervalState &in)
 	{
-		(*analysis)[name] = Interval(0, one.getUpper());
+		if (b == pinnedHeader)
+			pinVariables(in, loopPins);
 	}
+	bool evaluatesBlock(unsigned b) const { return !sliceActive || sliceBlocks[b]; }
+	bool evaluatesInstruction(const Instruction *I) const { return !sliceActive || sliceInstructions.count(I); }
+	unsigned long solveComponent(const BlockGraph &G, unsigned c, TraceSpan &span);
+	void prepare(const BlockGraph &G);
+	void clear();
+
+	unsigned long solveCountingLoop(const BlockGraph &G, unsigned c);
+};
+BranchIntervalProblem intervalProblem;
+
+//======================================================================
+// Counting loop acceleration (--accelerate)
+//======================================================================
+// In a loop such as
+//
+//     while (i++ < N) { ... x = x + 7; ... }
+//
+// the fixpoint moves i by one step per sweep until the guard stops it, and
+// x until the clamp does. A cyclic component that is a counting loop gets
+// their ranges in closed form instead. It is one when
+//
+//  - it is entered only at its first block, the header, and has no cycle
+//    that avoids the header;
+//  - the header ends in a branch on "counter R bound" that stays in the
+//    loop along one edge and leaves it along the other; the loop stores
+//    the counter once, as counter +/- a constant step, in the header or in
+//    the only block that branches back to it; the bound is a constant or
+//    a variable the loop does not store;
+//  - the loop stays while the counter is at most (least) a limit, and the
+//    step is positive (negative), so it stops after finitely many trips.
+//
+// Every other variable the loop only stores as itself +/- a constant is
+// linear: one iteration changes it by an amount within [lo, hi], which
+// depends on the path taken.
+//
+// The component is solved twice. The first solve pins the counter and
+// the linear variables to [NEG_INF, POS_INF] at the header's input, so it
+// converges in a few sweeps, and shows which edges an iteration can take.
+// The changes along those paths, with the trip counts the guard allows,
+// bound every pinned variable on all visits of the header and on the
+// visit that leaves it. The second solve pins the first of these at the
+// header's input; the edges leaving the header then start from the
+// header evaluated on the second. Both hold for every execution, although
+// an interval analysis of the body alone could not show it (x <= 700
+// above follows from i, which intervals do not relate to x).
+struct CountingLoop
+{
+	unsigned component;
+	unsigned header;
+	// by block id: index in the component, NOT_REACHABLE outside it
+	std::vector<unsigned> position;
+	// the counter, then the linear variables, and the change each block
+	// of the component (by index) makes to them
+	std::vector<std::string> vars;
+	std::vector<std::vector<int64_t> > deltas;
+	int64_t step;
+	bool testsUpdated;	// the guard reads the counter after the header stored it
+	bool upperLimit;	// stays while counter <= bound - offset, else while counter >= bound + offset
+	int offset;
+	bool constBound;
+	int64_t boundConst;
+	std::string boundVar;
+};
+
+// The arithmetic below stays far from int64_t overflow: a step larger than
+// the whole range [NEG_INF, POS_INF] is not accelerated, a constant bound
+// is clamped to +/- ACCEL_BOUND, and trip counts saturate at ACCEL_TRIPS,
+// beyond which every product with a nonzero step leaves the range anyway
+const static int64_t ACCEL_STEP = POS_INF - NEG_INF;
+const static int64_t ACCEL_BOUND = int64_t(1) << 40;
+const static int64_t ACCEL_TRIPS = POS_INF - NEG_INF + 1;
+
+// The constant stored adds to the value load read: load + C, C + load or
+// load - C, with |C| at most ACCEL_STEP
+bool constantStep(Value *stored, const LoadInst *load, int64_t &step)
+{
+	BinaryOperator *op = dyn_cast<BinaryOperator>(stored);
+	if (op == NULL)
+		return false;
+	ConstantInt *first = dyn_cast<ConstantInt>(op->getOperand(0));
+	ConstantInt *second = dyn_cast<ConstantInt>(op->getOperand(1));
+	if (op->getOpcode() == BinaryOperator::Add && op->getOperand(0) == load && second != NULL)
+		step = second->getSExtValue();
+	else if (op->getOpcode() == BinaryOperator::Add && op->getOperand(1) == load && first != NULL)
+		step = first->getSExtValue();
+	else if (op->getOpcode() == BinaryOperator::Sub && op->getOperand(0) == load && second != NULL)
+		step = second->getSExtValue();
 	else
-	{
-		(*analysis)[name] = Interval(0, two.getUpper() - 1);
-	}
+		return false;
+	if (step < -ACCEL_STEP || step > ACCEL_STEP)
+		return false;
+	if (op->getOpcode() == BinaryOperator::Sub)
+		step = -step;
+	return true;
 }
 
-BBANALYSIS updateBBAnalysis(BasicBlock *BB, BBANALYSIS analysis)
+// Inside the loop, var is only loaded, and stored when mayStore
+bool onlyLoadsAndStores(const BlockGraph &G, const CountingLoop &loop, AllocaInst *var, bool mayStore)
 {
-	// Loop through instructions in BB
-
-	for (auto &I : *BB)
+	for (auto U = var->user_begin(); U != var->user_end(); ++U)
 	{
-		if (isa<AllocaInst>(I))
-		{
-			processAlloca(&I, &analysis);
-		}
-		else if (isa<StoreInst>(I))
-		{
-			processStore(&I, &analysis);
-		}
-		else if (isa<LoadInst>(I))
-		{
-			processLoad(&I, &analysis);
-		}
-		else if (I.getOpcode() == BinaryOperator::Add)
-		{
-			processAdd(&I, &analysis);
-		}
-		else if (I.getOpcode() == BinaryOperator::Sub)
-		{
-			processSub(&I, &analysis);
-		}
-		else if (I.getOpcode() == BinaryOperator::Mul)
-		{
-			processMul(&I, &analysis);
-		}
-		else if (I.getOpcode() == BinaryOperator::SDiv)
-		{
-			processDiv(&I, &analysis);
-		}
-		else if (I.getOpcode() == BinaryOperator::SRem)
-		{
-			processRem(&I, &analysis);
-		}
+		Instruction *user = dyn_cast<Instruction>(*U);
+		if (user == NULL)
+			return false;
+		if (loop.position[G.id(user->getParent())] == BlockGraph::NOT_REACHABLE || isa<LoadInst>(user))
+			continue;
+		StoreInst *store = dyn_cast<StoreInst>(user);
+		if (!mayStore || store == NULL || store->getPointerOperand() != var || store->getValueOperand() == var)
+			return false;
 	}
-	return analysis;
+	return true;
 }
 
-BBANALYSIS ConstConstCondition(llvm::CmpInst *cmp, BBANALYSIS predSet, Value *op1, Value *op2, bool flag)
+// The change every block of the loop makes to var, when each store of var
+// in the loop adds a constant to a load of var since its last store;
+// stores counts them
+bool linearDeltas(const BlockGraph &G, const CountingLoop &loop, AllocaInst *var, std::vector<int64_t> &deltas, unsigned &stores)
 {
-	llvm::ConstantInt *CI = dyn_cast<ConstantInt>(op1);
-	int64_t op1Int = CI->getSExtValue();
-	llvm::ConstantInt *CII = dyn_cast<ConstantInt>(op2);
-	int64_t op2Int = CII->getSExtValue();
-	BBANALYSIS emptySet;
-	switch (cmp->getPredicate())
-	{
-	case llvm::CmpInst::ICMP_EQ:
-	{
-		if ((flag == true && op1Int == op2Int) || (flag == false && op1Int != op2Int))
-			return predSet;
-		else
+	if (!onlyLoadsAndStores(G, loop, var, true))
+		return false;
+	const unsigned *members = G.sccBegin(loop.component);
+	unsigned n = G.sccEnd(loop.component) - members;
+	deltas.assign(n, 0);
+	stores = 0;
+	for (unsigned i = 0; i < n; i++)
+	{
+		const LoadInst *current = NULL;
+		for (auto &I : *G.blocks[members[i]])
 		{
-			return emptySet;
+			if (LoadInst *load = dyn_cast<LoadInst>(&I))
+			{
+				if (load->getPointerOperand() == var)
+					current = load;
+			}
+			else if (StoreInst *store = dyn_cast<StoreInst>(&I))
+			{
+				if (store->getPointerOperand() != var)
+					continue;
+				int64_t step;
+				if (current == NULL || !constantStep(store->getValueOperand(), current, step))
+					return false;
+				deltas[i] += step;
+				stores++;
+				current = NULL;
+			}
 		}
 	}
-	case llvm::CmpInst::ICMP_NE:
+	return true;
+}
+
+// Recognize component c as a counting loop (see above) from its IR alone
+bool findCountingLoop(const BlockGraph &G, unsigned c, CountingLoop &loop)
+{
+	const unsigned *members = G.sccBegin(c);
+	unsigned n = G.sccEnd(c) - members;
+	loop.component = c;
+	loop.header = members[0];
+	if (G.rpoNumber[loop.header] == BlockGraph::NOT_REACHABLE)
+		return false;
+	loop.position.assign(G.size(), BlockGraph::NOT_REACHABLE);
+	for (unsigned i = 0; i < n; i++)
+		loop.position[members[i]] = i;
+
+	// one entry, and every cycle through the header: members are in
+	// reverse post-order, so any other edge goes forward
+	std::vector<unsigned> latches;
+	for (unsigned i = 0; i < n; i++)
 	{
-		if ((flag == true && op1Int != op2Int) || (flag == false && op1Int == op2Int))
-			return predSet;
-		else
+		for (const unsigned *pred = G.predBegin(members[i]); pred != G.predEnd(members[i]); ++pred)
 		{
-			return emptySet;
+			unsigned from = loop.position[*pred];
+			if (i == 0 && from != BlockGraph::NOT_REACHABLE)
+				latches.push_back(*pred);
+			else if (i != 0 && (from == BlockGraph::NOT_REACHABLE || from >= i))
+				return false;
 		}
 	}
-	case llvm::CmpInst::ICMP_SGT:
+
+	// the guard
+	BasicBlock *header = G.blocks[loop.header];
+	BranchInst *br = dyn_cast<BranchInst>(header->getTerminator());
+	if (br == NULL || !br->isConditional())
+		return false;
+	ICmpInst *cmp = dyn_cast<ICmpInst>(br->getCondition());
+	bool trueStays = loop.position[G.id(br->getSuccessor(0))] != BlockGraph::NOT_REACHABLE;
+	bool falseStays = loop.position[G.id(br->getSuccessor(1))] != BlockGraph::NOT_REACHABLE;
+	if (cmp == NULL || trueStays == falseStays)
+		return false;
+	const CompareRule *rule = getCompareRule(cmp->getPredicate(), trueStays);
+	if (rule == NULL || !rule->le || rule->ge || rule->ne || rule->isUnsigned)
+		return false;
+
+	// the variables the loop stores, and which of them are linear
+	std::vector<AllocaInst *> stored;
+	for (unsigned i = 0; i < n; i++)
 	{
-		if ((flag == true && op1Int > op2Int) || (flag == false && op1Int <= op2Int))
-			return predSet;
-		else
+		for (auto &I : *G.blocks[members[i]])
 		{
-			return emptySet;
+			StoreInst *store = dyn_cast<StoreInst>(&I);
+			AllocaInst *var = store != NULL ? dyn_cast<AllocaInst>(store->getPointerOperand()) : NULL;
+			if (var != NULL && std::find(stored.begin(), stored.end(), var) == stored.end())
+				stored.push_back(var);
 		}
 	}
-	case llvm::CmpInst::ICMP_SLT:
-	{
-		if ((flag == true && op1Int < op2Int) || (flag == false && op1Int >= op2Int))
-			return predSet;
-		else
+	std::vector<AllocaInst *> linear;
+	std::vector<std::vector<int64_t> > deltas;
+	std::vector<unsigned> storeCounts;
+	for (size_t v = 0; v < stored.size(); v++)
+	{
+		std::vector<int64_t> change;
+		unsigned stores;
+		if (!linearDeltas(G, loop, stored[v], change, stores))
+			continue;
+		linear.push_back(stored[v]);
+		deltas.push_back(change);
+		storeCounts.push_back(stores);
+	}
+
+	// the counter is a compared load in the header, of a linear variable
+	// stored once
+	unsigned side = 0, counter = linear.size();
+	LoadInst *counterLoad = NULL;
+	for (; side < 2 && counter == linear.size(); side++)
+	{
+		counterLoad = dyn_cast<LoadInst>(cmp->getOperand(side));
+		if (counterLoad == NULL || counterLoad->getParent() != header)
+			continue;
+		for (unsigned v = 0; v < linear.size(); v++)
 		{
-			return emptySet;
+			if (linear[v] == counterLoad->getPointerOperand() && storeCounts[v] == 1)
+				counter = v;
 		}
 	}
-	case llvm::CmpInst::ICMP_SGE:
+	if (counter == linear.size())
+		return false;
+	side--;
+	unsigned storedIn = std::find_if(deltas[counter].begin(), deltas[counter].end(), [](int64_t d) { return d != 0; }) - deltas[counter].begin();
+	if (storedIn == n)
+		return false;
+	for (size_t l = 0; l < latches.size() && storedIn != 0; l++)
 	{
-		if ((flag == true && op1Int >= op2Int) || (flag == false && op1Int < op2Int))
-			return predSet;
-		else
-		{
-			return emptySet;
-		}
+		if (latches[l] != members[storedIn])
+			return false;
 	}
-	case llvm::CmpInst::ICMP_SLE:
+	loop.step = deltas[counter][storedIn];
+	loop.testsUpdated = false;
+	if (storedIn == 0)
 	{
-		if ((flag == true && op1Int <= op2Int) || (flag == false && op1Int > op2Int))
-			return predSet;
-		else
+		for (auto I = header->begin(); &*I != counterLoad; ++I)
 		{
-			return emptySet;
+			StoreInst *store = dyn_cast<StoreInst>(&*I);
+			if (store != NULL && store->getPointerOperand() == linear[counter])
+				loop.testsUpdated = true;
 		}
 	}
-	}
-}
 
-BBANALYSIS VarConstCondition(llvm::CmpInst *cmp, std::string varName, BBANALYSIS predSet, Interval op1, Value *op2, bool flag)
-{
-
-	llvm::ConstantInt *CII = dyn_cast<ConstantInt>(op2);
-	int op2Int = CII->getSExtValue();
-	BBANALYSIS emptySet;
-	switch (cmp->getPredicate())
-	{
-	case llvm::CmpInst::ICMP_EQ:
-	{
-		if (flag == true)
-		{
-			if(op2Int >= op1.getLower() && op2Int <= op1.getUpper()){
-				predSet[varName] = Interval(op2Int, op2Int);
-				return predSet;
-			}else{
-				return emptySet;
-			}
-			
-		}
-		else
-		{
-			if(op1.getUpper() == op1.getLower() && op1.getLower() == op2Int){
-				return emptySet;
-			}else if(op1.getUpper() == op2Int){
-				op1.setUpper(op1.getUpper() - 1);
-				predSet[varName] = op1;
-				return predSet;
-			}else if(op1.getLower() == op2Int){
-				op1.setLower(op1.getLower() + 1);
-				predSet[varName] = op1;
-				return predSet;
-			}else{
-				return predSet;
-			}
-			
-		}
-	
-	}
-	case llvm::CmpInst::ICMP_NE:
-	{
-		if(flag == true){
-
-			if(op1.getUpper() == op1.getLower() && op1.getLower() == op2Int){
-				return emptySet;
-			}else if(op1.getUpper() == op2Int){
-				op1.setUpper(op1.getUpper() - 1);
-				predSet[varName] = op1;
-				return predSet;
-			}else if(op1.getLower() == op2Int){
-				op1.setLower(op1.getLower() + 1);
-				predSet[varName] = op1;
-				return predSet;
-			}else{
-				return predSet;
-			}
-		}else{
-			if(op2Int >= op1.getLower() && op2Int <= op1.getUpper()){
-				predSet[varName] = Interval(op2Int, op2Int);
-				return predSet;
-			}else{
-				return emptySet;
-			}
-		}
+	// the bound
+	Value *bound = cmp->getOperand(1 - side);
+	LoadInst *boundLoad = dyn_cast<LoadInst>(bound);
+	AllocaInst *boundVar = boundLoad != NULL ? dyn_cast<AllocaInst>(boundLoad->getPointerOperand()) : NULL;
+	loop.constBound = isa<ConstantInt>(bound);
+	if (loop.constBound)
+		loop.boundConst = std::min(std::max(dyn_cast<ConstantInt>(bound)->getSExtValue(), -ACCEL_BOUND), ACCEL_BOUND);
+	else if (boundVar != NULL && onlyLoadsAndStores(G, loop, boundVar, false))
+		loop.boundVar = getSimpleVarName(boundVar);
+	else
+		return false;
 
+	// "counter <= limit" when the counter is the left operand of an
+	// unswapped rule, or the right one of a swapped rule
+	loop.upperLimit = (side == 0) != rule->swap;
+	loop.offset = rule->offset;
+	if (loop.upperLimit ? loop.step <= 0 : loop.step >= 0)
+		return false;
 
-	}
-	case llvm::CmpInst::ICMP_SGT:
+	loop.vars.push_back(getSimpleVarName(linear[counter]));
+	loop.deltas.push_back(deltas[counter]);
+	for (unsigned v = 0; v < linear.size(); v++)
 	{
-		if(flag == true){
-			if(op1.getUpper() > op2Int){
-				op1.setLower(std::max(op1.getLower(), op2Int + 1));
-				predSet[varName] = op1;
-				return predSet;
-			}else{
-				return emptySet;
-			}
-
-		}else{
-			if(op1.getLower() > op2Int){
-				return emptySet;
-			}else{
-				op1.setUpper(std::min(op1.getUpper(), op2Int));
-				predSet[varName] = op1;
-				return predSet;
-			}
+		if (v == counter)
+			continue;
+		loop.vars.push_back(getSimpleVarName(linear[v]));
+		loop.deltas.push_back(deltas[v]);
+	}
+	return true;
+}
 
-		}
+// floor(a / b) for b > 0
+int64_t floorDiv(int64_t a, int64_t b)
+{
+	return a >= 0 ? a / b : -((-a + b - 1) / b);
+}
 
-	}
-	case llvm::CmpInst::ICMP_SLT:
-	{
-		if(flag == true){
-			if(op1.getLower() >= op2Int){
-				return emptySet;
-			}else{
-				op1.setUpper(std::min(op2Int-1, op1.getUpper()));
-				predSet[varName] = op1;
-				return predSet;
-			}
-		}else{
-			if(op1.getUpper() < op2Int){
-				return emptySet;
-			}else{
-				op1.setLower(std::max(op1.getLower(),op2Int));
-				predSet[varName] = op1;
-				return predSet;
-			}
-		}
-	}
-	case llvm::CmpInst::ICMP_SGE:
-	{
-		if(flag == true){
-			if(op1.getUpper() < op2Int){
-				return emptySet;
-			}else{
-				op1.setLower(std::max(op1.getLower(),op2Int));
-				predSet[varName] = op1;
-				return predSet;
-			}
-		}
-		else{
-			if(op1.getLower() >= op2Int){
-				return emptySet;
-			}else{
-				op1.setUpper(std::min(op2Int-1, op1.getUpper()));
-				predSet[varName] = op1;
-				return predSet;
-			}
-		}
+// Iterations the loop makes when the guard first tests counter value t
+// against limit, at most ACCEL_TRIPS
+int64_t tripCount(const CountingLoop &loop, int64_t t, int64_t limit)
+{
+	int64_t trips = loop.upperLimit ? floorDiv(limit - t, loop.step) + 1 : floorDiv(t - limit, -loop.step) + 1;
+	return std::min(std::max<int64_t>(trips, 0), ACCEL_TRIPS);
+}
 
-	}
-	case llvm::CmpInst::ICMP_SLE:
-	{
-		if(flag == true){
-			if(op1.getLower() > op2Int){
-				return emptySet;
-			}else{
-				op1.setUpper(std::min(op1.getUpper(), op2Int));
-				predSet[varName] = op1;
-				return predSet;
-			}
-		}else{
-			if(op1.getUpper() > op2Int){
-				op1.setLower(std::max(op1.getLower(), op2Int + 1));
-				predSet[varName] = op1;
-				return predSet;
-			}else{
-				return emptySet;
-			}
-		}
+// Pin variable id to lo..hi, clamped to [NEG_INF, POS_INF]
+void setPin(FlatIntervalState &pins, unsigned id, int64_t lo, int64_t hi)
+{
+	Interval pinned((int)std::min<int64_t>(std::max<int64_t>(lo, NEG_INF), POS_INF),
+					(int)std::min<int64_t>(std::max<int64_t>(hi, NEG_INF), POS_INF));
+	pins.set(id, pinned.getLower(), pinned.getUpper());
+}
 
-	}
-	}
+// The interval of id in state when it is present and finite
+bool finiteBounds(const FlatIntervalState &state, unsigned id, int64_t &lo, int64_t &hi)
+{
+	if (id == VariableTable::NOT_FOUND || !state.has(id) || state.lower[id] == NEG_INF || state.upper[id] == POS_INF)
+		return false;
+	lo = state.lower[id];
+	hi = state.upper[id];
+	return true;
 }
 
-BBANALYSIS ConstVarCondition(llvm::CmpInst *cmp, std::string varName, BBANALYSIS predSet, Value *op1, Interval op2, bool flag)
+// Solve component c of G as a counting loop; the number of sweeps, or 0
+// when c is not one and is left unsolved
+unsigned long BranchIntervalProblem::solveCountingLoop(const BlockGraph &G, unsigned c)
 {
+	CountingLoop loop;
+	if (!findCountingLoop(G, c, loop))
+		return 0;
+	std::vector<unsigned> ids;
+	for (size_t v = 0; v < loop.vars.size(); v++)
+		ids.push_back(variables.lookup(loop.vars[v]));
+
+	// the values the loop is entered with; the bound keeps its value
+	// throughout the loop
+	FlatIntervalState entry;
+	for (unsigned slot = G.predOffset[loop.header]; slot != G.predOffset[loop.header + 1]; slot++)
+	{
+		if (loop.position[G.preds[slot]] == BlockGraph::NOT_REACHABLE)
+			joinEdge(entry, G.preds[slot], slot);
+	}
+	int64_t counterLo, counterHi, boundLo, boundHi;
+	if (!finiteBounds(entry, ids[0], counterLo, counterHi))
+		return 0;
+	if (loop.constBound)
+		boundLo = boundHi = loop.boundConst;
+	else if (!finiteBounds(entry, variables.lookup(loop.boundVar), boundLo, boundHi))
+		return 0;
+	STATS_COUNT(stats, "loops_accelerated");
+
+	// first solve, with the pinned variables unknown
+	pinnedHeader = loop.header;
+	loopPins.clear();
+	for (size_t v = 0; v < ids.size(); v++)
+	{
+		if (ids[v] != VariableTable::NOT_FOUND)
+			loopPins.set(ids[v], NEG_INF, POS_INF);
+	}
+	unsigned long sweeps = dataflow::solveScc(*this, G, c);
+	spill.touch(blockStates, loop.header);
+	if (blockStates[loop.header].isEmpty())
+	{
+		pinnedHeader = BlockGraph::NOT_REACHABLE;
+		return sweeps;
+	}
+
+	// the edges an iteration can take
+	const unsigned *members = G.sccBegin(c);
+	unsigned n = G.sccEnd(c) - members;
+	std::vector<char> taken(G.preds.size(), 0);
+	for (unsigned i = 0; i < n; i++)
+	{
+		for (unsigned slot = G.predOffset[members[i]]; slot != G.predOffset[members[i] + 1]; slot++)
+		{
+			unsigned from = G.preds[slot];
+			if (loop.position[from] == BlockGraph::NOT_REACHABLE)
+				continue;
+			spill.touch(blockStates, from);
+			conditional = blockStates[from];
+			applyCond(conditional, edgeTable[slot]);
+			taken[slot] = !conditional.isEmpty();
+		}
+	}
 
-	llvm::ConstantInt *CI = dyn_cast<ConstantInt>(op1);
-	int op1Int = CI->getSExtValue();
-	BBANALYSIS emptySet;
-	switch (cmp->getPredicate())
+	// the change of every pinned variable along those paths, from the
+	// start of the header to the end of each block, and over a whole
+	// iteration: from the header back to it
+	std::vector<Bounds> iteration(ids.size(), Bounds(0, 0));
+	bool iterates = false;
+	for (size_t v = 0; v < ids.size(); v++)
 	{
-	case llvm::CmpInst::ICMP_EQ:
-	{
-		if (flag == true)
+		std::vector<Bounds> change(n, Bounds(0, 0));
+		std::vector<char> reached(n, 0);
+		reached[0] = 1;
+		for (unsigned i = 0; i < n; i++)
 		{
-			if(op1Int >= op2.getLower() && op1Int <= op2.getUpper()){
-				predSet[varName] = Interval(op1Int, op1Int);
-				return predSet;
-			}else{
-				return emptySet;
+			for (unsigned slot = G.predOffset[members[i]]; i != 0 && slot != G.predOffset[members[i] + 1]; slot++)
+			{
+				unsigned from = loop.position[G.preds[slot]];
+				if (!taken[slot] || !reached[from])
+					continue;
+				change[i] = reached[i] ? Bounds(std::min(change[i].lo, change[from].lo), std::max(change[i].hi, change[from].hi)) : change[from];
+				reached[i] = 1;
 			}
-			
+			change[i].lo += loop.deltas[v][i];
+			change[i].hi += loop.deltas[v][i];
 		}
-		else
+		bool any = false;
+		for (unsigned slot = G.predOffset[loop.header]; slot != G.predOffset[loop.header + 1]; slot++)
 		{
-			if(op2.getUpper() == op2.getLower() && op2.getLower() == op1Int){
-				return emptySet;
-			}else if(op2.getUpper() == op1Int){
-				op2.setUpper(op2.getUpper() - 1);
-				predSet[varName] = op2;
-				return predSet;
-			}else if(op2.getLower() == op1Int){
-				op2.setLower(op2.getLower() + 1);
-				predSet[varName] = op2;
-				return predSet;
-			}else{
-				return predSet;
-			}
-			
+			unsigned from = loop.position[G.preds[slot]];
+			if (from == BlockGraph::NOT_REACHABLE || !taken[slot] || !reached[from])
+				continue;
+			iteration[v] = any ? Bounds(std::min(iteration[v].lo, change[from].lo), std::max(iteration[v].hi, change[from].hi)) : change[from];
+			any = true;
 		}
-	
+		iterates = any;
 	}
-	case llvm::CmpInst::ICMP_NE:
-	{
-		if(flag == true){
-
-			if(op2.getUpper() == op2.getLower() && op2.getLower() == op1Int){
-				return emptySet;
-			}else if(op2.getUpper() == op1Int){
-				op2.setUpper(op2.getUpper() - 1);
-				predSet[varName] = op2;
-				return predSet;
-			}else if(op2.getLower() == op1Int){
-				op2.setLower(op2.getLower() + 1);
-				predSet[varName] = op2;
-				return predSet;
-			}else{
-				return predSet;
-			}
-		}else{
-			if(op1Int >= op2.getLower() && op1Int <= op2.getUpper()){
-				predSet[varName] = Interval(op1Int, op1Int);
-				return predSet;
-			}else{
-				return emptySet;
-			}
-		}
-
 
-	}
-	case llvm::CmpInst::ICMP_SGT:
+	// trip counts, from the counter value the guard first tests
+	int64_t tested = loop.testsUpdated ? loop.step : 0;
+	int64_t limitLo = loop.upperLimit ? boundLo - loop.offset : boundLo + loop.offset;
+	int64_t limitHi = loop.upperLimit ? boundHi - loop.offset : boundHi + loop.offset;
+	int64_t tripMin = 0, tripMax = 0;
+	if (iterates)
 	{
-		if(flag == true){
-			if(op2.getLower() >= op1Int){
-				return emptySet;
-			}else{
-				op2.setUpper(std::min(op1Int-1, op2.getUpper()));
-				predSet[varName] = op2;
-				return predSet;
-			}
-		}
-		else{
-			
-			if(op2.getUpper() < op1Int){
-				return emptySet;
-			}else{
-				op2.setLower(std::max(op2.getLower(),op1Int));
-				predSet[varName] = op2;
-				return predSet;
-			}
-		}
-
+		tripMax = loop.upperLimit ? tripCount(loop, counterLo + tested, limitHi) : tripCount(loop, counterHi + tested, limitLo);
+		tripMin = loop.upperLimit ? tripCount(loop, counterHi + tested, limitLo) : tripCount(loop, counterLo + tested, limitHi);
 	}
-	case llvm::CmpInst::ICMP_SGE:
-	{
-		if(flag == true){
-			if(op2.getLower() > op1Int){
-				return emptySet;
-			}else{
-				op2.setUpper(std::min(op2.getUpper(), op1Int));
-				predSet[varName] = op2;
-				return predSet;
-			}
-
-		}else{
-			
-			if(op2.getUpper() > op1Int){
-				op2.setLower(std::max(op2.getLower(), op1Int + 1));
-				predSet[varName] = op2;
-				return predSet;
-			}else{
-				return emptySet;
-			}
-
-		}
 
-	}
-	case llvm::CmpInst::ICMP_SLT:
+	// the counter on every visit of the header, and on the one that
+	// leaves: after tripMin to tripMax steps, with the guard holding on
+	// the visit before and failing on it
+	int64_t visitLo = counterLo, visitHi = counterHi, exitLo, exitHi;
+	if (loop.upperLimit)
 	{
-		if(flag == true){
-			if(op2.getUpper() > op1Int){
-				op2.setLower(std::max(op2.getLower(), op1Int + 1));
-				predSet[varName] = op2;
-				return predSet;
-			}else{
-				return emptySet;
-			}
-		}else{
-			
-			if(op2.getLower() > op1Int){
-				return emptySet;
-			}else{
-				op2.setUpper(std::min(op2.getUpper(), op1Int));
-				predSet[varName] = op2;
-				return predSet;
-			}
-		}
-
-		
+		visitHi = std::min(counterHi + tripMax * loop.step, std::max(counterHi, limitHi + loop.step - tested));
+		exitLo = std::max(counterLo + tripMin * loop.step, limitLo + 1 - tested);
+		exitHi = visitHi;
 	}
-	
-	case llvm::CmpInst::ICMP_SLE:
+	else
 	{
-		
-		if(flag == true){
-			if(op2.getUpper() < op1Int){
-				return emptySet;
-			}else{
-				op2.setLower(std::max(op2.getLower(),op1Int));
-				predSet[varName] = op2;
-				return predSet;
-			}
-		}else{
-			
-			if(op2.getLower() >= op1Int){
-				return emptySet;
-			}else{
-				op2.setUpper(std::min(op1Int-1, op2.getUpper()));
-				predSet[varName] = op2;
-				return predSet;
-			}
+		visitLo = std::max(counterLo + tripMax * loop.step, std::min(counterLo, limitLo + loop.step - tested));
+		exitLo = visitLo;
+		exitHi = std::min(counterHi + tripMin * loop.step, limitHi - 1 - tested);
+	}
+	FlatIntervalState exitPins;
+	loopPins.clear();
+	setPin(loopPins, ids[0], visitLo, visitHi);
+	setPin(exitPins, ids[0], exitLo, exitHi);
+	// a linear variable after k iterations, for k up to tripMax on any
+	// visit and from tripMin on the last; infinite bounds stay infinite
+	for (size_t v = 1; v < ids.size(); v++)
+	{
+		if (ids[v] == VariableTable::NOT_FOUND || !entry.has(ids[v]))
+			continue;
+		int64_t lo = entry.lower[ids[v]], hi = entry.upper[ids[v]];
+		const Bounds &d = iteration[v];
+		setPin(loopPins, ids[v], lo == NEG_INF ? lo : lo + std::min<int64_t>(0, tripMax * d.lo),
+			   hi == POS_INF ? hi : hi + std::max<int64_t>(0, tripMax * d.hi));
+		setPin(exitPins, ids[v], lo == NEG_INF ? lo : lo + std::min(tripMin * d.lo, tripMax * d.lo),
+			   hi == POS_INF ? hi : hi + std::max(tripMin * d.hi, tripMax * d.hi));
+	}
+
+	// second solve, from scratch
+	for (unsigned i = 0; i < n; i++)
+	{
+		spill.touch(blockStates, members[i]);
+		blockStates[members[i]].clear();
+		spill.charge(blockStates, members[i]);
+		blockFingerprint[members[i]].valid = false;
+		blockVersion[members[i]]++;
+	}
+	sweeps += dataflow::solveScc(*this, G, c);
+
+	// the header on its last visit, for the edges that leave the loop; no
+	// such visit when the guard cannot fail
+	scratchArena.reset();
+	FlatIntervalState exitInput;
+	Base::joinInputs(*this, G, loop.header, exitInput);
+	if (exitLo > exitHi)
+		exitInput.clear();
+	pinVariables(exitInput, exitPins);
+	applyBlock(loop.header, exitInput);
+	loopExitStates[loop.header] = exitInput;
+	for (const unsigned *succ = G.succBegin(loop.header); succ != G.succEnd(loop.header); ++succ)
+	{
+		if (loop.position[*succ] != BlockGraph::NOT_REACHABLE)
+			continue;
+		for (unsigned slot = G.predOffset[*succ]; slot != G.predOffset[*succ + 1]; slot++)
+		{
+			if (G.preds[slot] == loop.header)
+				exitEdgeOverride[slot] = 1;
 		}
 	}
-	
-	}
+	pinnedHeader = BlockGraph::NOT_REACHABLE;
+	return sweeps;
 }
 
-
-bool isIntersected(Interval one, Interval two)
+// --accelerate: a cyclic component is first tried as a counting loop
+unsigned long BranchIntervalProblem::solveComponent(const BlockGraph &G, unsigned c, TraceSpan &span)
 {
-
-	return std::max(one.getLower(), two.getLower()) <= std::min(one.getUpper(), two.getUpper());
+	unsigned long sweeps = 0;
+	if (accelerateLoops && !sliceActive && G.isCyclicScc(c))
+		sweeps = solveCountingLoop(G, c);
+	if (sweeps != 0)
+	{
+		span.arg("accelerated", 1ul);
+		return sweeps;
+	}
+	return dataflow::solveScc(*this, G, c);
 }
-Interval intersection(Interval one, Interval two)
-{
 
-	return Interval(std::max(one.getLower(), two.getLower()), std::min(one.getUpper(), two.getUpper()));
+void BranchIntervalProblem::prepare(const BlockGraph &G)
+{
+	loopExitStates.assign(G.size(), FlatIntervalState());
+	exitEdgeOverride.assign(G.preds.size(), 0);
+	buildEdgeTable(G, variables);
 }
 
-BBANALYSIS VarVarCondition(llvm::CmpInst *cmp, std::string varName1, std::string varName2, BBANALYSIS predSet, Interval op1, Interval op2, bool flag)
+// Forget every result so another function can be solved
+void BranchIntervalProblem::clear()
 {
+	IntervalProblem<BranchIntervalProblem>::clear();
+	edgeTable.clear();
+	loopExitStates.clear();
+	exitEdgeOverride.clear();
+	sliceActive = false;
+	sliceBlocks.clear();
+	sliceInstructions.clear();
+}
 
-	BBANALYSIS emptySet;
-	switch (cmp->getPredicate())
-	{
-	case llvm::CmpInst::ICMP_EQ:
+// The user variables of every block of G with their intervals, read from
+// the solved states one block at a time
+void printIntervals(const BlockGraph &G, raw_ostream &out)
+{
+	std::vector<unsigned> userVars = intervalProblem.userVariables();
+	std::vector<unsigned> order = intervalProblem.blocksByLabel(G);
+	for (size_t n = 0; n < order.size(); n++)
 	{
-		if (flag == true)
-		{
-			if (isIntersected(op1, op2))
-			{
-				Interval a = intersection(op1, op2);
-				predSet[varName1] = a;
-				predSet[varName2] = a;
-				return predSet;
-			}
-			else
-			{
-				return emptySet;
-			}
-		}
-		else
+		out << "Block name is:" << G.labels[order[n]] << "\n";
+		const FlatIntervalState &analysis = intervalProblem.result(order[n]);
+		for (size_t v = 0; v < userVars.size(); v++)
 		{
-			if (op1.getLower() == op1.getUpper() && op2.getLower() == op2.getUpper() && op1.getLower() == op2.getLower())
-			{
-				return emptySet;
-			}
-			else
-			{
-				return predSet;
+			if(analysis.has(userVars[v])){
+				out << intervalProblem.variables.names[userVars[v]];
+				out << "\t";
+				out << BranchIntervalProblem::intervalOf(analysis, userVars[v]).toString();
+				out << "\n";
 			}
+			
 		}
 	}
-	case llvm::CmpInst::ICMP_NE:
+}
+
+//======================================================================
+// Demand-driven queries
+//======================================================================
+// The interval of variable X at block B only depends on the blocks that
+// can reach B and, within them, on the variables X is computed from: the
+// ones loaded into values stored to X, transitively, and the ones tested
+// by every branch on the way, since an infeasible edge empties the whole
+// state. queryInterval() solves just that slice by switching every other
+// block and instruction off. A solved slice is kept and answers any later
+// query whose block and variable it contains: slices are closed under
+// predecessors and dependencies, so it then contains that query's slice.
+// The decoded blocks and the edge table are built by the first query, and
+// every slice solve starts over only the blocks in its slice.
+
+typedef std::map<std::string, std::map<std::string, Interval> > IntervalResult;
+
+struct SolvedSlice
+{
+	std::vector<char> blocks;
+	std::set<std::string> vars;
+	IntervalResult result;
+};
+std::vector<SolvedSlice> solvedSlices;
+
+// Add the instructions computing V to the slice, and queue the variables
+// it loads
+void addValueSlice(Value *V, std::set<std::string> &vars, std::vector<std::string> &pending)
+{
+	Instruction *I = dyn_cast<Instruction>(V);
+	if (I == nullptr || !sliceInstructions.insert(I).second)
+		return;
+	if (LoadInst *load = dyn_cast<LoadInst>(I))
 	{
-		if (flag == false)
+		if (Instruction *address = dyn_cast<Instruction>(load->getPointerOperand()))
 		{
-			if (isIntersected(op1, op2))
-			{
-				Interval a = intersection(op1, op2);
-				predSet[varName1] = a;
-				predSet[varName2] = a;
-				return predSet;
-			}
-			else
-			{
-				return emptySet;
-			}
-		}
-		else
-		{
-			if (op1.getLower() == op1.getUpper() && op2.getLower() == op2.getUpper() && op1.getLower() == op2.getLower())
-			{
-				return emptySet;
-			}
-			else
-			{
-				return predSet;
-			}
+			std::string name = getSimpleVarName(address);
+			if (vars.insert(name).second)
+				pending.push_back(name);
 		}
 	}
-	case llvm::CmpInst::ICMP_SGT:
+	else if (isa<BinaryOperator>(I))
 	{
-		if (flag == true)
-		{
-			if (op1.getUpper() <= op2.getLower())
-				return emptySet;
-			else
-			{
-				op1.setLower(std::min(op2.getLower() + 1, op1.getLower()));
-				op2.setUpper(std::min(op1.getUpper() - 1, op2.getUpper()));
-				predSet[varName1] = op1;
-				predSet[varName2] = op2;
-				return predSet;
-			}
-		}
-		else
-		{
-			if (op1.getLower() > op2.getUpper())
-			{
-				return emptySet;
-			}
-			op1.setUpper(std::min(op1.getUpper(), op2.getUpper()));
-			op2.setLower(std::max(op1.getLower(), op2.getLower()));
-			predSet[varName1] = op1;
-			predSet[varName2] = op2;
-			return predSet;
-		}
+		addValueSlice(I->getOperand(0), vars, pending);
+		addValueSlice(I->getOperand(1), vars, pending);
 	}
-	case llvm::CmpInst::ICMP_SLT:
-	{
-		if (flag == true)
+}
+
+// Select the slice of (var, block b) and return its variables; reads the
+// edge table, so G must be prepared (IntervalProblem::prepareFunction)
+std::set<std::string> computeSlice(const BlockGraph &G, unsigned b, const std::string &var)
+{
+	sliceBlocks.assign(G.size(), 0);
+	sliceInstructions.clear();
+	std::vector<unsigned> stack(1, b);
+	sliceBlocks[b] = 1;
+	while (!stack.empty())
+	{
+		unsigned n = stack.back();
+		stack.pop_back();
+		for (const unsigned *pred = G.predBegin(n); pred != G.predEnd(n); ++pred)
 		{
-			if (op1.getLower() >= op2.getUpper())
+			if (!sliceBlocks[*pred])
 			{
-				return emptySet;
+				sliceBlocks[*pred] = 1;
+				stack.push_back(*pred);
 			}
-			else
-			{
-				op1.setUpper(std::min(op1.getUpper(), op2.getLower() - 1));
-				op2.setLower(std::max(op1.getLower() + 1, op2.getLower()));
-				predSet[varName1] = op1;
-				predSet[varName2] = op2;
-				return predSet;
-			}
-		}else{
-			if(op1.getUpper() < op2.getLower()){
-				return emptySet;
-			}else{
-				op1.setLower(std::max(op1.getLower(),op2.getLower()));
-				op2.setUpper(std::min(op1.getUpper(),op2.getUpper()));
-				predSet[varName1] = op1;
-				predSet[varName2] = op2;
-				return predSet;
-			}
-
 		}
 	}
-	case llvm::CmpInst::ICMP_SGE:
+
+	std::set<std::string> vars;
+	std::vector<std::string> pending;
+	vars.insert(var);
+	pending.push_back(var);
+	std::map<std::string, std::vector<Instruction *> > definitions;
+	for (unsigned n = 0; n < G.size(); n++)
 	{
-		if (flag == true)
+		if (!sliceBlocks[n])
+			continue;
+		for (unsigned slot = G.predOffset[n]; slot != G.predOffset[n + 1]; slot++)
 		{
-			if(op1.getUpper() < op2.getLower()){
-				return emptySet;
-			}else{
-				op1.setLower(std::max(op1.getLower(),op2.getLower()));
-				op2.setUpper(std::min(op1.getUpper(),op2.getUpper()));
-				predSet[varName1] = op1;
-				predSet[varName2] = op2;
-				return predSet;
-			}
+			const EdgeRefinement &edge = edgeTable[slot];
+			if (!edge.varName1.empty() && vars.insert(edge.varName1).second)
+				pending.push_back(edge.varName1);
+			if (!edge.varName2.empty() && vars.insert(edge.varName2).second)
+				pending.push_back(edge.varName2);
 		}
-		else
+		for (auto &I : *G.blocks[n])
 		{
-			if (op1.getLower() >= op2.getUpper())
-			{
-				return emptySet;
-			}
-			else
-			{
-				op1.setUpper(std::min(op1.getUpper(), op2.getLower() - 1));
-				op2.setLower(std::max(op1.getLower() + 1, op2.getLower()));
-				predSet[varName1] = op1;
-				predSet[varName2] = op2;
-				return predSet;
-			}
+			if (isa<AllocaInst>(I))
+				definitions[getSimpleVarName(&I)].push_back(&I);
+			else if (isa<StoreInst>(I) && isa<Instruction>(I.getOperand(1)))
+				definitions[getSimpleVarName(dyn_cast<Instruction>(I.getOperand(1)))].push_back(&I);
 		}
 	}
-	case llvm::CmpInst::ICMP_SLE:
+
+	while (!pending.empty())
 	{
-		if (flag == true)
+		std::vector<Instruction *> &defs = definitions[pending.back()];
+		pending.pop_back();
+		for (size_t i = 0; i < defs.size(); i++)
 		{
-			if (op1.getLower() > op2.getUpper())
-			{
-				return emptySet;
-			}
-			op1.setUpper(std::min(op1.getUpper(), op2.getUpper()));
-			op2.setLower(std::max(op1.getLower(), op2.getLower()));
-			predSet[varName1] = op1;
-			predSet[varName2] = op2;
-			return predSet;
+			sliceInstructions.insert(defs[i]);
+			if (isa<StoreInst>(defs[i]))
+				addValueSlice(defs[i]->getOperand(0), vars, pending);
 		}
-		else
+	}
+	return vars;
+}
+
+// Interval of var at the block labelled block; false when the block is
+// unknown or var has no interval there
+bool queryInterval(const BlockGraph &G, const std::string &block, const std::string &var, Interval &interval)
+{
+	unsigned b = G.idOfLabel(block);
+	if (b == G.size())
+		return false;
+	const SolvedSlice *slice = nullptr;
+	for (size_t i = 0; i < solvedSlices.size() && slice == nullptr; i++)
+	{
+		if (solvedSlices[i].blocks[b] && solvedSlices[i].vars.count(var))
+			slice = &solvedSlices[i];
+	}
+	if (slice == nullptr)
+	{
+		STATS_COUNT(stats, "slices_solved");
+		StatsPhase initPhase(stats, "init");
+		// the edge table and the decoded blocks are built by the first
+		// query and kept for the others
+		intervalProblem.prepareFunction(G);
+		SolvedSlice solved;
+		solved.vars = computeSlice(G, b, var);
+		solved.blocks = sliceBlocks;
+		sliceActive = true;
+		intervalProblem.solve(G, initPhase);
+		for (unsigned n = 0; n < G.size(); n++)
 		{
-			if (op1.getUpper() <= op2.getLower())
-				return emptySet;
-			else
+			if (!solved.blocks[n])
+				continue;
+			const FlatIntervalState &analysis = intervalProblem.result(n);
+			std::map<std::string, Interval> &intervals = solved.result[G.labels[n]];
+			for (unsigned id = 0; id < analysis.size(); id++)
 			{
-				op1.setLower(std::min(op2.getLower() + 1, op1.getLower()));
-				op2.setUpper(std::min(op1.getUpper() - 1, op2.getUpper()));
-				predSet[varName1] = op1;
-				predSet[varName2] = op2;
-				return predSet;
+				const std::string &name = intervalProblem.variables.names[id];
+				if (analysis.has(id) && solved.vars.count(name))
+					intervals[name] = BranchIntervalProblem::intervalOf(analysis, id);
 			}
+			// the answers are kept in solved; the state is not needed again
+			intervalProblem.forgetBlock(n);
 		}
+		solvedSlices.push_back(solved);
+		slice = &solvedSlices.back();
 	}
+	else
+	{
+		STATS_COUNT(stats, "slice_hits");
 	}
+	const std::map<std::string, Interval> &intervals = slice->result.find(block)->second;
+	auto it = intervals.find(var);
+	if (it == intervals.end())
+		return false;
+	interval = it->second;
+	return true;
 }
 
-BBANALYSIS applyCond(BBANALYSIS predSet, BasicBlock *predecessor, BasicBlock *BB)
+//======================================================================
+// Daemon mode
+//======================================================================
+// Besides analyze/invalidate/shutdown (see Daemon.h) the daemon answers
+//
+//     interval FILE BLOCK VAR   ->   ok [ lower , upper ]
+
+bool solveFile(const std::string &path, IntervalResult &result)
 {
-	for (auto &I : *predecessor)
+	SMDiagnostic Err;
+	Module *M = loadModule(path, Err, getGlobalContext());
+	if (M == nullptr)
+		return false;
+	Function *F = M->getFunction("main");
+	if (F == nullptr || F->empty())
+	{
+		delete M;
+		return false;
+	}
+	result.clear();
 	{
-		if (isa<BranchInst>(I))
+		BlockGraph G(F);
+		StatsPhase initPhase(stats, "init");
+		intervalProblem.solve(G, initPhase);
+		for (unsigned b = 0; b < G.size(); b++)
 		{
-			BranchInst *br = dyn_cast<BranchInst>(&I);
-			if (!br->isConditional())
-				return predSet;
-			llvm::CmpInst *cmp = dyn_cast<llvm::CmpInst>(br->getCondition());
-
-			Value *op1 = cmp->getOperand(0);
-			Value *op2 = cmp->getOperand(1);
-
-			// now need to consider 3 cases: const-const  const-var   var-var
-			bool flag;
-			if (BB == br->getOperand(2))
-				flag = true;
-			if (BB == br->getOperand(1))
-				flag = false;
-
-			if (isa<ConstantInt>(op1) && isa<ConstantInt>(op2))
-			{
-				return ConstConstCondition(cmp, predSet, op1, op2, flag);
-			}
-
-			if (isa<LoadInst>(dyn_cast<Instruction>(cmp->getOperand(0))) && isa<ConstantInt>(op2))
-			{
-				Instruction *l = dyn_cast<Instruction>(cmp->getOperand(0));
-				std::string varName = getSimpleVarName(dyn_cast<Instruction>(l->getOperand(0)));
-				if (predSet.find(varName) == predSet.end())
-				{
-					return predSet;
-				}
-
-				return VarConstCondition(cmp, varName, predSet, predSet[varName], op2, flag);
-			}
-
-			if (isa<LoadInst>(dyn_cast<Instruction>(cmp->getOperand(0))) && isa<LoadInst>(dyn_cast<Instruction>(cmp->getOperand(1))))
+			const FlatIntervalState &analysis = intervalProblem.result(b);
+			std::map<std::string, Interval> &intervals = result[G.labels[b]];
+			for (unsigned id = 0; id < analysis.size(); id++)
 			{
-				Instruction *l1 = dyn_cast<Instruction>(cmp->getOperand(0));
-				std::string varName1 = getSimpleVarName(dyn_cast<Instruction>(l1->getOperand(0)));
-				Instruction *l2 = dyn_cast<Instruction>(cmp->getOperand(1));
-				std::string varName2 = getSimpleVarName(dyn_cast<Instruction>(l2->getOperand(0)));
-
-				if (predSet.find(varName1) == predSet.end() || predSet.find(varName2) == predSet.end())
-				{
-					return predSet;
-				}
-				return VarVarCondition(cmp,varName1,varName2,predSet,predSet[varName1],predSet[varName2],flag);
+				if (analysis.has(id))
+					intervals[intervalProblem.variables.names[id]] = BranchIntervalProblem::intervalOf(analysis, id);
 			}
 		}
 	}
-	return predSet;
+	intervalProblem.clear();
+	delete M;
+	return true;
 }
 
-// update Graph Analysis
-void updateGraphAnalysis(Function *F)
+FileCache<IntervalResult> intervalCache(solveFile);
+
+std::string handleRequest(const std::vector<std::string> &words)
 {
-	for (auto &BB : *F)
+	if (words[0] == "analyze" && words.size() == 2)
 	{
-		BBANALYSIS predUnion;
-		// Load the current stored analysis for all predecessor nodes
-		for (auto it = pred_begin(&BB), et = pred_end(&BB); it != et; ++it)
-		{
-
-			BasicBlock *predecessor = *it;
-			std::string predecessorName = getSimpleNodeLabel(predecessor);
-			if (activeBlocks.find(predecessorName) != activeBlocks.end())
-			{
-				// in this way, we need to merge all the predecessor information
-				BBANALYSIS conditional = applyCond(analysisMap[getSimpleNodeLabel(predecessor)], predecessor, &BB);
-				predUnion = union_analysis(predUnion, conditional);
-			}
-			/*
-			else
-			{
-				llvm::errs() << "Block " << predecessorName << " not in the active list\n";
-			}*/
-		}
+		const IntervalResult *result = intervalCache.get(words[1]);
+		if (result == nullptr)
+			return "error cannot analyze " + words[1];
+		return "ok " + std::to_string(result->size()) + " blocks";
+	}
+	if (words[0] == "invalidate" && words.size() == 2)
+	{
+		intervalCache.invalidate(words[1]);
+		return "ok";
+	}
+	if (words[0] == "interval" && words.size() == 4)
+	{
+		const IntervalResult *result = intervalCache.get(words[1]);
+		if (result == nullptr)
+			return "error cannot analyze " + words[1];
+		auto block = result->find(words[2]);
+		if (block == result->end())
+			return "error no block " + words[2];
+		auto var = block->second.find(words[3]);
+		if (var == block->second.end())
+			return "error no variable " + words[3] + " at " + words[2];
+		return "ok " + var->second.toString();
+	}
+	return "error unknown request " + words[0];
+}
 
-		BBANALYSIS BBAnalysis = updateBBAnalysis(&BB, predUnion);
-		BBANALYSIS OldBBAnalysis = analysisMap[getSimpleNodeLabel(&BB)];
-		if (!CheckBbanalysisEquals(OldBBAnalysis, BBAnalysis))
+// Print "BLOCK VAR [ lower , upper ]" for every BLOCK:VAR query
+void answerQueries(const BlockGraph &G, const std::vector<std::string> &queries, StatsPhase &initPhase)
+{
+	initPhase.stop();
+	for (size_t i = 0; i < queries.size(); i++)
+	{
+		size_t colon = queries[i].rfind(':');
+		if (colon == std::string::npos)
 		{
-			analysisMap[getSimpleNodeLabel(&BB)] = union_analysis(BBAnalysis, OldBBAnalysis);
+			llvm::errs() << "error: query \"" << queries[i] << "\" is not BLOCK:VAR\n";
+			continue;
 		}
+		std::string block = queries[i].substr(0, colon);
+		std::string var = queries[i].substr(colon + 1);
+		Interval interval;
+		if (queryInterval(G, block, var, interval))
+			llvm::errs() << block << "\t" << var << "\t" << interval.toString() << "\n";
+		else
+			llvm::errs() << block << "\t" << var << "\tunknown\n";
 	}
 }
 
@@ -1115,62 +1232,148 @@ void updateGraphAnalysis(Function *F)
 // main function
 //======================================================================
 
+#ifndef CS5218_PLUGIN
 int main(int argc, char **argv)
 {
 	// Read the IR file.
 	LLVMContext &Context = getGlobalContext();
 	SMDiagnostic Err;
 
+	// Options: the ones of every interval tool (see
+	// IntervalProblem::parseOption), and
+	// --daemon=socket serves queries instead of analyzing one file,
+	// --query=BLOCK:VAR (repeatable) solves only what each query needs,
+	// --accelerate solves counting loops in closed form (see solveCountingLoop)
+	IntervalOptions options;
+	const char *daemonSocket = nullptr;
+	std::vector<std::string> queries;
+	for (int i = 1; i < argc; i++)
+	{
+		if (!strncmp(argv[i], "--daemon=", 9))
+			daemonSocket = argv[i] + 9;
+		else if (!strncmp(argv[i], "--query=", 8))
+			queries.push_back(argv[i] + 8);
+		else if (!strcmp(argv[i], "--accelerate"))
+			accelerateLoops = true;
+		else
+		{
+			OptionStatus status = intervalProblem.parseOption(argv[i], options);
+			if (status == OPTION_INVALID)
+				return EXIT_FAILURE;
+			if (status == OPTION_UNKNOWN)
+				options.inputFile = argv[i];
+		}
+	}
+	if (!intervalProblem.checkOptions())
+		return EXIT_FAILURE;
+	// loops are accelerated one component at a time
+	if (accelerateLoops && !intervalProblem.sccSchedule)
+	{
+		fprintf(stderr, "error: --accelerate needs --schedule=scc\n");
+		return EXIT_FAILURE;
+	}
+	if (daemonSocket != nullptr)
+		return serveRequests(daemonSocket, handleRequest);
+	const char *inputFile = options.inputFile;
+	if (inputFile == nullptr)
+	{
+		fprintf(stderr, "usage: %s [--memo-stats] [--stats[=file]] [--trace=file] [--profile-dot=file] [--query=BLOCK:VAR]... [--prepass=list] [--schedule=scc|rounds] [--memory-budget=size] [--accelerate] [--widen[=N]] <file.ll|file.c>\n"
+						"       %s --daemon=socket\n", argv[0], argv[0]);
+		return EXIT_FAILURE;
+	}
+
+	if (options.traceFile != nullptr)
+		tracer.enable();
+
 	// Extract Module M from IR (assuming only one Module exists)
-	Module *M = ParseIRFile(argv[1], Err, Context);
+	StatsPhase parsePhase(stats, "parse");
+	TraceSpan parseSpan(tracer, "phase", "parse");
+	Module *M = loadModule(inputFile, Err, Context);
 	if (M == nullptr)
 	{
-		fprintf(stderr, "error: failed to load LLVM IR file \"%s\"", argv[1]);
+		fprintf(stderr, "error: failed to load LLVM IR file \"%s\"", inputFile);
 		return EXIT_FAILURE;
 	}
+	parsePhase.stop();
+	parseSpan.stop();
 
 	// 1.Extract Function main from Module M
+	StatsPhase initPhase(stats, "init");
 	Function *F = M->getFunction("main");
+	runPrePasses(*F, options.prePasses);
+	BlockGraph G(F);
+	if (options.profileFile != nullptr)
+		profile.enable(G.size());
+
+	// with queries only their answers are printed
+	if (queries.empty())
+		intervalProblem.solve(G, initPhase);
+	else
+		answerQueries(G, queries, initPhase);
+
+	StatsPhase outputPhase(stats, "output");
+	TraceSpan outputSpan(tracer, "phase", "output");
+	if (queries.empty())
+		printIntervals(G, llvm::errs());
+	outputPhase.stop();
+	outputSpan.stop();
 
-	// 2.Define analysisMap as a mapping of basic block labels to empty set (of instructions):
-	for (auto &BB : *F)
+	if (options.memoStats)
+		intervalProblem.printMemoStats();
+	if (options.traceFile != nullptr)
+		tracer.write(options.traceFile);
+	if (options.profileFile != nullptr)
+		profile.writeDot(options.profileFile, G, inputFile);
+	if (options.writeStats)
 	{
-		BBANALYSIS emptySet;
-		std::string blockName = getSimpleNodeLabel(&BB);
-		analysisMap[blockName] = emptySet;
-		activeBlocks.insert(blockName);
+		stats.set("blocks", G.size());
+		intervalProblem.recordStats();
+		writeStatsReport(stats, options.statsFile, "part2", inputFile);
 	}
-	// Note: All variables are of type "alloca" instructions. Ex.
-	// Variable a: %a = alloca i32, align 4
 
-	// Keeping a snapshot of the previous ananlysis
-	std::map<std::string, BBANALYSIS> oldAnalysisMap;
-	// Fixpoint Loop
+	return 0;
+}
+#endif
+
+#ifdef CS5218_PLUGIN
+// Pass plugin (see PassPlugin.h): the intervals of main, written to
+// <input>.intervals or -cs5218-intervals-output
+namespace
+{
+cl::opt<std::string> IntervalsOutput("cs5218-intervals-output", cl::desc("file the cs5218-intervals report is written to"), cl::value_desc("file"));
+
+struct IntervalPass : public FunctionPass
+{
+	static char ID;
+	IntervalPass() : FunctionPass(ID) {}
 
-	int i = 0;
-	while (!fixPointReached(oldAnalysisMap, F))
+	bool runOnFunction(Function &F) override
 	{
-		oldAnalysisMap.clear();
-		oldAnalysisMap.insert(analysisMap.begin(), analysisMap.end());
-		updateGraphAnalysis(F);
-		activeBlocks.clear();
+		if (F.getName() != "main" || F.empty())
+			return false;
+		BlockGraph G(&F);
+		StatsPhase initPhase(stats, "init");
+		intervalProblem.solve(G, initPhase);
+		std::string report;
+		raw_string_ostream out(report);
+		printIntervals(G, out);
+		out.flush();
+		writePluginOutput(pluginOutputPath(*F.getParent(), IntervalsOutput, ".intervals"), report);
+		intervalProblem.clear();
+		return false;
 	}
-
-	for (auto it = analysisMap.begin(); it != analysisMap.end(); ++it)
+	void getAnalysisUsage(AnalysisUsage &AU) const override
 	{
-		llvm::errs() << "Block name is:" << it->first << "\n";
-		BBANALYSIS analysis = it->second;
-		for (auto it1 = analysis.begin(); it1 != analysis.end(); ++it1)
-		{
-			if(it1->first.find("%")== std::string::npos){
-				llvm::errs() << it1->first;
-				llvm::errs() << "\t";
-				llvm::errs() << (it1->second).toString();
-				llvm::errs() << "\n";
-			}
-			
-		}
+		AU.setPreservesAll();
 	}
+};
+} // namespace
 
-	return 0;
+char IntervalPass::ID = 0;
+static RegisterPass<IntervalPass> RegisterIntervals("cs5218-intervals", "CS5218 interval analysis of main", false, true);
+static void addIntervalPass(const PassManagerBuilder &, legacy::PassManagerBase &PM)
+{
+	PM.add(new IntervalPass());
 }
+static RegisterStandardPasses RegisterIntervalsInClang(PassManagerBuilder::EP_EarlyAsPossible, addIntervalPass);
+#endif
@@ -0,0 +1,138 @@
+#ifndef CS5218_ANALYSIS_STATS_H
+#define CS5218_ANALYSIS_STATS_H
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "llvm/Support/raw_ostream.h"
+
+#include "StringEscape.h"
+
+//======================================================================
+// Run statistics (--stats)
+//======================================================================
+// Counters are plain integers handed out by reference, so a call site
+// caches the reference once and pays a single increment per event:
+//
+//     STATS_COUNT(stats, "processAdd");
+//
+// They are always collected; --stats only decides whether the JSON
+// report is written. Phases are timed with a steady clock and reported in
+// the order they ran.
+class AnalysisStats
+{
+  public:
+	AnalysisStats() {}
+
+	uint64_t &counter(const std::string &name)
+	{
+		for (size_t i = 0; i < counters.size(); i++)
+		{
+			if (counters[i]->first == name)
+				return counters[i]->second;
+		}
+		// entries are never moved, so references stay valid
+		counters.push_back(new std::pair<std::string, uint64_t>(name, 0));
+		return counters.back()->second;
+	}
+
+	void set(const std::string &name, uint64_t value) { counter(name) = value; }
+
+	void addPhase(const std::string &name, double ms)
+	{
+		for (size_t i = 0; i < phases.size(); i++)
+		{
+			if (phases[i].first == name)
+			{
+				phases[i].second += ms;
+				return;
+			}
+		}
+		phases.push_back(std::make_pair(name, ms));
+	}
+
+	void writeJSON(llvm::raw_ostream &OS, const std::string &tool, const std::string &input) const
+	{
+		OS << "{\"tool\": \"" << escapeString(tool) << "\", \"input\": \"" << escapeString(input) << "\", \"phases_ms\": {";
+		for (size_t i = 0; i < phases.size(); i++)
+		{
+			char buf[32];
+			snprintf(buf, sizeof(buf), "%.3f", phases[i].second);
+			OS << (i ? ", " : "") << "\"" << escapeString(phases[i].first) << "\": " << buf;
+		}
+		OS << "}, \"counters\": {";
+		for (size_t i = 0; i < counters.size(); i++)
+			OS << (i ? ", " : "") << "\"" << escapeString(counters[i]->first) << "\": " << counters[i]->second;
+		OS << "}}\n";
+	}
+
+	~AnalysisStats()
+	{
+		for (size_t i = 0; i < counters.size(); i++)
+			delete counters[i];
+	}
+
+  private:
+	std::vector<std::pair<std::string, uint64_t> *> counters;
+	std::vector<std::pair<std::string, double> > phases;
+
+	AnalysisStats(const AnalysisStats &);
+	AnalysisStats &operator=(const AnalysisStats &);
+};
+
+#define STATS_COUNT(stats, name)                                   \
+	do                                                             \
+	{                                                              \
+		static uint64_t &statsCounter = (stats).counter(name);    \
+		statsCounter++;                                            \
+	} while (0)
+
+// Writes the JSON report to path, or to stderr when path is NULL
+inline bool writeStatsReport(const AnalysisStats &stats, const char *path, const std::string &tool, const std::string &input)
+{
+	std::string json;
+	llvm::raw_string_ostream OS(json);
+	stats.writeJSON(OS, tool, input);
+	OS.flush();
+	FILE *out = path ? fopen(path, "w") : stderr;
+	if (out == NULL)
+	{
+		fprintf(stderr, "error: cannot write statistics to \"%s\"\n", path);
+		return false;
+	}
+	fputs(json.c_str(), out);
+	if (path)
+		fclose(out);
+	return true;
+}
+
+// Times one phase, from construction until stop() or the end of the
+// enclosing scope
+class StatsPhase
+{
+  public:
+	StatsPhase(AnalysisStats &stats, const char *name)
+		: stats(stats), name(name), start(std::chrono::steady_clock::now()), running(true) {}
+	~StatsPhase() { stop(); }
+
+	void stop()
+	{
+		if (!running)
+			return;
+		running = false;
+		std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+		stats.addPhase(name, elapsed.count());
+	}
+
+  private:
+	AnalysisStats &stats;
+	const char *name;
+	std::chrono::steady_clock::time_point start;
+	bool running;
+};
+
+#endif
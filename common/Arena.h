@@ -0,0 +1,176 @@
+#ifndef CS5218_ARENA_H
+#define CS5218_ARENA_H
+
+#include <cstddef>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+#include <utility>
+#include <vector>
+
+//======================================================================
+// Bump allocator with bulk reset
+//======================================================================
+// Memory is handed out from large chunks and never freed one object at a
+// time; reset() rewinds to the first chunk and keeps every chunk for
+// reuse, so a run that resets between steps settles on a handful of
+// chunk allocations. Objects placed in an arena must not be used after
+// the arena is reset.
+class Arena
+{
+  public:
+	explicit Arena(size_t chunkSize = 64 * 1024) : chunkSize(chunkSize), current(0), ptr(NULL), end(NULL) {}
+	~Arena()
+	{
+		for (size_t i = 0; i < chunks.size(); i++)
+			free(chunks[i].base);
+	}
+
+	void *allocate(size_t size, size_t align)
+	{
+		char *p = alignUp(ptr, align);
+		if (ptr == NULL || p + size > end)
+		{
+			nextChunk(size + align);
+			p = alignUp(ptr, align);
+		}
+		ptr = p + size;
+		return p;
+	}
+
+	void reset()
+	{
+		current = 0;
+		ptr = chunks.empty() ? NULL : chunks[0].base;
+		end = chunks.empty() ? NULL : chunks[0].base + chunks[0].size;
+	}
+
+	// bytes reserved from the system, across all chunks
+	size_t capacity() const
+	{
+		size_t total = 0;
+		for (size_t i = 0; i < chunks.size(); i++)
+			total += chunks[i].size;
+		return total;
+	}
+	size_t numChunks() const { return chunks.size(); }
+
+  private:
+	struct Chunk
+	{
+		char *base;
+		size_t size;
+	};
+	size_t chunkSize;
+	std::vector<Chunk> chunks;
+	size_t current;
+	char *ptr;
+	char *end;
+
+	Arena(const Arena &);
+	Arena &operator=(const Arena &);
+
+	static char *alignUp(char *p, size_t align)
+	{
+		return (char *)(((size_t)p + align - 1) & ~(align - 1));
+	}
+
+	// move to the next chunk that can hold size bytes, reusing chunks kept
+	// by reset() before asking the system for a new one
+	void nextChunk(size_t size)
+	{
+		size_t i = ptr == NULL ? 0 : current + 1;
+		for (; i < chunks.size(); i++)
+		{
+			if (chunks[i].size >= size)
+				break;
+		}
+		if (i == chunks.size())
+		{
+			Chunk chunk;
+			chunk.size = size > chunkSize ? size : chunkSize;
+			chunk.base = (char *)malloc(chunk.size);
+			if (chunk.base == NULL)
+			{
+				fputs("error: out of memory\n", stderr);
+				abort();
+			}
+			chunks.push_back(chunk);
+		}
+		current = i;
+		ptr = chunks[i].base;
+		end = chunks[i].base + chunks[i].size;
+	}
+};
+
+// Arena that default-constructed ArenaAllocators draw from; NULL means the
+// global heap.
+inline Arena *&currentArena()
+{
+	static Arena *arena = NULL;
+	return arena;
+}
+
+//======================================================================
+// STL allocator over an Arena
+//======================================================================
+// deallocate() is a no-op; the memory comes back when the arena is reset.
+// Copying a container does not keep the source's arena: the copy is
+// scratch and goes to currentArena(), so only containers constructed
+// explicitly with an arena (and then assigned to) live in it.
+template <class T>
+class ArenaAllocator
+{
+  public:
+	typedef T value_type;
+	typedef T *pointer;
+	typedef const T *const_pointer;
+	typedef T &reference;
+	typedef const T &const_reference;
+	typedef size_t size_type;
+	typedef ptrdiff_t difference_type;
+	template <class U>
+	struct rebind
+	{
+		typedef ArenaAllocator<U> other;
+	};
+
+	Arena *arena;
+
+	ArenaAllocator() : arena(currentArena()) {}
+	explicit ArenaAllocator(Arena *arena) : arena(arena) {}
+	template <class U>
+	ArenaAllocator(const ArenaAllocator<U> &other) : arena(other.arena) {}
+
+	pointer allocate(size_type n, const void * = 0)
+	{
+		if (arena == NULL)
+			return static_cast<pointer>(::operator new(n * sizeof(T)));
+		return static_cast<pointer>(arena->allocate(n * sizeof(T), alignof(T)));
+	}
+	void deallocate(pointer p, size_type)
+	{
+		if (arena == NULL)
+			::operator delete(p);
+	}
+
+	ArenaAllocator select_on_container_copy_construction() const { return ArenaAllocator(); }
+
+	size_type max_size() const { return size_type(-1) / sizeof(T); }
+	pointer address(reference x) const { return &x; }
+	const_pointer address(const_reference x) const { return &x; }
+	template <class U, class... Args>
+	void construct(U *p, Args &&... args) { ::new ((void *)p) U(std::forward<Args>(args)...); }
+	template <class U>
+	void destroy(U *p) { p->~U(); }
+};
+
+template <class T, class U>
+bool operator==(const ArenaAllocator<T> &a, const ArenaAllocator<U> &b) { return a.arena == b.arena; }
+template <class T, class U>
+bool operator!=(const ArenaAllocator<T> &a, const ArenaAllocator<U> &b) { return a.arena != b.arena; }
+
+template <class T>
+using ArenaVector = std::vector<T, ArenaAllocator<T> >;
+
+#endif
@@ -0,0 +1,228 @@
+#ifndef CS5218_BLOCK_GRAPH_H
+#define CS5218_BLOCK_GRAPH_H
+
+#include <algorithm>
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/IR/BasicBlock.h"
+#include "llvm/IR/CFG.h"
+#include "llvm/IR/Function.h"
+#include "llvm/IR/Instructions.h"
+
+// Every tool prints blocks through its own getSimpleNodeLabel().
+std::string getSimpleNodeLabel(const llvm::BasicBlock *Node);
+
+//======================================================================
+// Compressed-sparse-row CFG
+//======================================================================
+// Built once per function and shared by every analysis. Blocks get dense
+// ids in function order (so id 0 is the entry block); the successors of
+// block b are succs[succOffset[b] .. succOffset[b+1]) in terminator order
+// and its predecessors are preds[predOffset[b] .. predOffset[b+1]) in
+// pred_begin() order, so a "pred slot" indexes per-incoming-edge tables.
+// Labels are computed once here, since printing an unnamed block walks the
+// whole function.
+class BlockGraph
+{
+  public:
+	enum { NOT_REACHABLE = ~0u };
+
+	std::vector<llvm::BasicBlock *> blocks;
+	std::vector<std::string> labels;
+	std::vector<unsigned> succOffset;
+	std::vector<unsigned> succs;
+	std::vector<unsigned> predOffset;
+	std::vector<unsigned> preds;
+	// reachable blocks in reverse post-order, and each block's position in
+	// it (NOT_REACHABLE for blocks the entry cannot reach)
+	std::vector<unsigned> rpo;
+	std::vector<unsigned> rpoNumber;
+	// per successor slot: the edge closes a cycle of the depth-first walk
+	std::vector<bool> backEdge;
+	// strongly connected components in topological order: every edge stays
+	// inside a component or leads to a later one. The members of component
+	// c are sccMembers[sccOffset[c] .. sccOffset[c+1]) in reverse
+	// post-order (unreachable blocks last, in function order).
+	std::vector<unsigned> sccOffset;
+	std::vector<unsigned> sccMembers;
+	std::vector<unsigned> sccOf;
+	// per component: it has a cycle, i.e. more than one block or a self loop
+	std::vector<bool> sccCyclic;
+
+	explicit BlockGraph(llvm::Function *F)
+	{
+		for (auto &BB : *F)
+		{
+			ids[&BB] = blocks.size();
+			labelIds[getSimpleNodeLabel(&BB)] = blocks.size();
+			blocks.push_back(&BB);
+			labels.push_back(getSimpleNodeLabel(&BB));
+		}
+		succOffset.push_back(0);
+		predOffset.push_back(0);
+		for (unsigned b = 0; b < blocks.size(); b++)
+		{
+			const llvm::TerminatorInst *TInst = blocks[b]->getTerminator();
+			unsigned NSucc = TInst ? TInst->getNumSuccessors() : 0;
+			for (unsigned i = 0; i < NSucc; i++)
+				succs.push_back(ids[TInst->getSuccessor(i)]);
+			succOffset.push_back(succs.size());
+			for (auto it = llvm::pred_begin(blocks[b]), et = llvm::pred_end(blocks[b]); it != et; ++it)
+				preds.push_back(ids[*it]);
+			predOffset.push_back(preds.size());
+		}
+		computeOrder();
+		computeSccs();
+	}
+
+	unsigned size() const { return blocks.size(); }
+	unsigned id(const llvm::BasicBlock *BB) const { return ids.lookup(BB); }
+	// id of the block printed as label, or size() when there is none
+	unsigned idOfLabel(const std::string &label) const
+	{
+		std::map<std::string, unsigned>::const_iterator it = labelIds.find(label);
+		return it == labelIds.end() ? size() : it->second;
+	}
+
+	const unsigned *succBegin(unsigned b) const { return succs.data() + succOffset[b]; }
+	const unsigned *succEnd(unsigned b) const { return succs.data() + succOffset[b + 1]; }
+	const unsigned *predBegin(unsigned b) const { return preds.data() + predOffset[b]; }
+	const unsigned *predEnd(unsigned b) const { return preds.data() + predOffset[b + 1]; }
+	unsigned numSuccs(unsigned b) const { return succOffset[b + 1] - succOffset[b]; }
+	unsigned numPreds(unsigned b) const { return predOffset[b + 1] - predOffset[b]; }
+	bool isBackEdge(unsigned b, unsigned i) const { return backEdge[succOffset[b] + i]; }
+	unsigned numSccs() const { return sccCyclic.size(); }
+	const unsigned *sccBegin(unsigned c) const { return sccMembers.data() + sccOffset[c]; }
+	const unsigned *sccEnd(unsigned c) const { return sccMembers.data() + sccOffset[c + 1]; }
+	bool isCyclicScc(unsigned c) const { return sccCyclic[c]; }
+
+  private:
+	llvm::DenseMap<const llvm::BasicBlock *, unsigned> ids;
+	std::map<std::string, unsigned> labelIds;
+
+	// Iterative depth-first walk from the entry: post-order gives the RPO,
+	// and an edge into a block still on the stack is a back edge.
+	void computeOrder()
+	{
+		rpoNumber.assign(size(), NOT_REACHABLE);
+		backEdge.assign(succs.size(), false);
+		if (size() == 0)
+			return;
+		std::vector<char> state(size(), 0); // 0 new, 1 on stack, 2 done
+		std::vector<unsigned> postOrder;
+		std::vector<std::pair<unsigned, unsigned> > stack;
+		stack.push_back(std::make_pair(0u, succOffset[0]));
+		state[0] = 1;
+		while (!stack.empty())
+		{
+			unsigned b = stack.back().first;
+			unsigned &slot = stack.back().second;
+			if (slot == succOffset[b + 1])
+			{
+				state[b] = 2;
+				postOrder.push_back(b);
+				stack.pop_back();
+				continue;
+			}
+			unsigned s = succs[slot];
+			if (state[s] == 1)
+				backEdge[slot] = true;
+			slot++;
+			if (state[s] == 0)
+			{
+				state[s] = 1;
+				stack.push_back(std::make_pair(s, succOffset[s]));
+			}
+		}
+		rpo.assign(postOrder.rbegin(), postOrder.rend());
+		for (unsigned i = 0; i < rpo.size(); i++)
+			rpoNumber[rpo[i]] = i;
+	}
+
+	// Iterative Tarjan over every block, the entry first. Components come
+	// out in reverse topological order, so they are stored back to front.
+	void computeSccs()
+	{
+		unsigned n = size();
+		std::vector<unsigned> index(n, NOT_REACHABLE), low(n, 0);
+		std::vector<char> onStack(n, 0);
+		std::vector<unsigned> stack;
+		std::vector<std::pair<unsigned, unsigned> > work;
+		std::vector<std::vector<unsigned> > found;
+		unsigned next = 0;
+		for (unsigned root = 0; root < n; root++)
+		{
+			if (index[root] != NOT_REACHABLE)
+				continue;
+			index[root] = low[root] = next++;
+			stack.push_back(root);
+			onStack[root] = 1;
+			work.push_back(std::make_pair(root, succOffset[root]));
+			while (!work.empty())
+			{
+				unsigned b = work.back().first;
+				if (work.back().second != succOffset[b + 1])
+				{
+					unsigned s = succs[work.back().second++];
+					if (index[s] == NOT_REACHABLE)
+					{
+						index[s] = low[s] = next++;
+						stack.push_back(s);
+						onStack[s] = 1;
+						work.push_back(std::make_pair(s, succOffset[s]));
+					}
+					else if (onStack[s])
+						low[b] = std::min(low[b], index[s]);
+					continue;
+				}
+				work.pop_back();
+				if (!work.empty())
+					low[work.back().first] = std::min(low[work.back().first], low[b]);
+				if (low[b] != index[b])
+					continue;
+				found.push_back(std::vector<unsigned>());
+				unsigned member;
+				do
+				{
+					member = stack.back();
+					stack.pop_back();
+					onStack[member] = 0;
+					found.back().push_back(member);
+				} while (member != b);
+			}
+		}
+
+		sccOf.assign(n, 0);
+		sccOffset.assign(1, 0);
+		for (size_t i = found.size(); i-- > 0;)
+		{
+			std::vector<unsigned> &members = found[i];
+			std::sort(members.begin(), members.end(), RpoLess(rpoNumber));
+			bool cyclic = members.size() > 1;
+			for (size_t m = 0; m < members.size(); m++)
+			{
+				sccOf[members[m]] = sccCyclic.size();
+				cyclic = cyclic || std::find(succBegin(members[m]), succEnd(members[m]), members[m]) != succEnd(members[m]);
+			}
+			sccMembers.insert(sccMembers.end(), members.begin(), members.end());
+			sccOffset.push_back(sccMembers.size());
+			sccCyclic.push_back(cyclic);
+		}
+	}
+
+	struct RpoLess
+	{
+		const std::vector<unsigned> &rpoNumber;
+		explicit RpoLess(const std::vector<unsigned> &rpoNumber) : rpoNumber(rpoNumber) {}
+		bool operator()(unsigned a, unsigned b) const
+		{
+			return rpoNumber[a] != rpoNumber[b] ? rpoNumber[a] < rpoNumber[b] : a < b;
+		}
+	};
+};
+
+#endif
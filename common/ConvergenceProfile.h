@@ -0,0 +1,112 @@
+#ifndef CS5218_CONVERGENCE_PROFILE_H
+#define CS5218_CONVERGENCE_PROFILE_H
+
+#include <algorithm>
+#include <cstdio>
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "BlockGraph.h"
+#include "StringEscape.h"
+
+//======================================================================
+// Convergence profile (--profile-dot=file)
+//======================================================================
+// Counts, per block, how often its transfer function ran, how often that
+// changed the block's stored state, and which variables the changes
+// touched. writeDot() draws the CFG with every block filled in
+// proportion to its evaluation count, so the loop headers that keep the
+// fixpoint going stand out; back edges are dashed.
+class ConvergenceProfile
+{
+  public:
+	ConvergenceProfile() : enabled(false) {}
+
+	void enable(unsigned numBlocks)
+	{
+		enabled = true;
+		blocks.assign(numBlocks, BlockCounts());
+	}
+	bool isEnabled() const { return enabled; }
+
+	void recordEvaluation(unsigned b) { blocks[b].evaluations++; }
+	void recordSkip(unsigned b) { blocks[b].skips++; }
+	void recordChange(unsigned b) { blocks[b].changes++; }
+	void recordChangedVar(unsigned b, const std::string &var) { blocks[b].changedVars[var]++; }
+
+	// Variables whose name contains '%' are compiler temporaries; only a
+	// count of them is shown.
+	bool writeDot(const char *path, const BlockGraph &G, const char *title) const
+	{
+		FILE *out = fopen(path, "w");
+		if (out == NULL)
+		{
+			fprintf(stderr, "error: cannot write profile to \"%s\"\n", path);
+			return false;
+		}
+		unsigned long maxEvaluations = 1;
+		for (size_t b = 0; b < blocks.size(); b++)
+			maxEvaluations = std::max(maxEvaluations, blocks[b].evaluations);
+
+		fprintf(out, "digraph \"%s\" {\n", escapeString(title).c_str());
+		fprintf(out, "\tnode [shape=box, style=filled, fontname=\"monospace\"];\n");
+		for (unsigned b = 0; b < G.size(); b++)
+		{
+			const BlockCounts &counts = blocks[b];
+			std::string label = escapeString(G.labels[b]) + "\\nevaluated " + std::to_string(counts.evaluations) +
+								", skipped " + std::to_string(counts.skips) + ", changed " + std::to_string(counts.changes);
+
+			std::vector<std::pair<unsigned long, std::string> > vars;
+			unsigned long temporaries = 0;
+			for (auto it = counts.changedVars.begin(); it != counts.changedVars.end(); ++it)
+			{
+				if (it->first.find('%') == std::string::npos)
+					vars.push_back(std::make_pair(it->second, it->first));
+				else
+					temporaries++;
+			}
+			std::sort(vars.begin(), vars.end(), moreChanges);
+			for (size_t i = 0; i < vars.size(); i++)
+				label += "\\l  " + escapeString(vars[i].second) + ": " + std::to_string(vars[i].first);
+			if (temporaries)
+				label += "\\l  (" + std::to_string(temporaries) + " temporaries)";
+			label += "\\l";
+
+			// white for blocks evaluated once or never, red for the hottest
+			// (all white when no block was evaluated more than once)
+			double heat = 0;
+			if (counts.evaluations > 1 && maxEvaluations > 1)
+				heat = (double)(counts.evaluations - 1) / (maxEvaluations - 1);
+			fprintf(out, "\tb%u [label=\"%s\", fillcolor=\"0.000 %.3f 1.000\"];\n", b, label.c_str(), heat);
+		}
+		for (unsigned b = 0; b < G.size(); b++)
+		{
+			for (unsigned i = 0; i < G.numSuccs(b); i++)
+				fprintf(out, "\tb%u -> b%u%s;\n", b, G.succBegin(b)[i], G.isBackEdge(b, i) ? " [style=dashed]" : "");
+		}
+		fputs("}\n", out);
+		fclose(out);
+		return true;
+	}
+
+  private:
+	struct BlockCounts
+	{
+		unsigned long evaluations;
+		unsigned long skips;
+		unsigned long changes;
+		std::map<std::string, unsigned long> changedVars;
+		BlockCounts() : evaluations(0), skips(0), changes(0) {}
+	};
+	bool enabled;
+	std::vector<BlockCounts> blocks;
+
+	static bool moreChanges(const std::pair<unsigned long, std::string> &a, const std::pair<unsigned long, std::string> &b)
+	{
+		return a.first != b.first ? a.first > b.first : a.second < b.second;
+	}
+};
+
+#endif
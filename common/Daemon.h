@@ -0,0 +1,242 @@
+#ifndef CS5218_DAEMON_H
+#define CS5218_DAEMON_H
+
+#include <cerrno>
+#include <csignal>
+#include <cstdio>
+#include <cstring>
+#include <map>
+#include <string>
+#include <vector>
+
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+//======================================================================
+// Query daemon over a Unix domain socket (--daemon=socket)
+//======================================================================
+// The protocol is line based: a client sends one request per line and
+// gets one response line back, starting with "ok" or "error". Words are
+// separated by blanks; a word containing blanks can be double-quoted.
+// Every tool understands
+//
+//     analyze FILE      solve FILE now (cached results are reused while
+//                       the file is unchanged)
+//     invalidate FILE   drop the cached results for FILE
+//     shutdown          stop the daemon
+//
+// and adds its own queries. Clients are served one at a time, and a
+// connection may carry any number of requests.
+
+// Turns one request into one response line (without the newline)
+typedef std::string (*DaemonHandler)(const std::vector<std::string> &words);
+
+inline std::vector<std::string> splitRequest(const std::string &line)
+{
+	std::vector<std::string> words;
+	size_t i = 0;
+	while (i < line.size())
+	{
+		if (line[i] == ' ' || line[i] == '\t' || line[i] == '\r')
+		{
+			i++;
+			continue;
+		}
+		std::string word;
+		if (line[i] == '"')
+		{
+			for (i++; i < line.size() && line[i] != '"'; i++)
+				word += line[i];
+			i++;
+		}
+		else
+		{
+			for (; i < line.size() && line[i] != ' ' && line[i] != '\t' && line[i] != '\r'; i++)
+				word += line[i];
+		}
+		words.push_back(word);
+	}
+	return words;
+}
+
+//======================================================================
+// Per-file result cache
+//======================================================================
+// An entry stays valid while the file's size, inode and modification time
+// are unchanged; get() checks them on every lookup, so an edited file is
+// solved again on its next query without any explicit invalidation.
+template <class Result>
+class FileCache
+{
+  public:
+	typedef bool (*Solver)(const std::string &path, Result &result);
+
+	explicit FileCache(Solver solve) : solve(solve) {}
+
+	// NULL when the file cannot be read or solved
+	const Result *get(const std::string &path)
+	{
+		struct stat st;
+		if (stat(path.c_str(), &st) != 0)
+		{
+			entries.erase(path);
+			return NULL;
+		}
+		typename std::map<std::string, Entry>::iterator it = entries.find(path);
+		if (it != entries.end() && it->second.matches(st))
+			return &it->second.result;
+
+		Entry entry;
+		entry.size = st.st_size;
+		entry.inode = st.st_ino;
+		entry.mtime = st.st_mtime;
+		entry.mtimeNsec = mtimeNsec(st);
+		if (!solve(path, entry.result))
+		{
+			entries.erase(path);
+			return NULL;
+		}
+		entries[path] = entry;
+		return &entries[path].result;
+	}
+
+	void invalidate(const std::string &path) { entries.erase(path); }
+
+  private:
+	struct Entry
+	{
+		off_t size;
+		ino_t inode;
+		time_t mtime;
+		long mtimeNsec;
+		Result result;
+
+		bool matches(const struct stat &st) const
+		{
+			return size == st.st_size && inode == st.st_ino && mtime == st.st_mtime && mtimeNsec == FileCache::mtimeNsec(st);
+		}
+	};
+	Solver solve;
+	std::map<std::string, Entry> entries;
+
+	static long mtimeNsec(const struct stat &st)
+	{
+#if defined(__APPLE__)
+		return st.st_mtimespec.tv_nsec;
+#elif defined(__linux__)
+		return st.st_mtim.tv_nsec;
+#else
+		return 0;
+#endif
+	}
+};
+
+inline bool writeAll(int fd, const std::string &data)
+{
+	size_t done = 0;
+	while (done < data.size())
+	{
+		ssize_t n = write(fd, data.data() + done, data.size() - done);
+		if (n < 0 && errno == EINTR)
+			continue;
+		if (n <= 0)
+			return false;
+		done += n;
+	}
+	return true;
+}
+
+// Serves requests on socketPath until a shutdown request; returns the
+// process exit status.
+inline int serveRequests(const char *socketPath, DaemonHandler handler)
+{
+	struct sockaddr_un addr;
+	memset(&addr, 0, sizeof(addr));
+	addr.sun_family = AF_UNIX;
+	if (strlen(socketPath) >= sizeof(addr.sun_path))
+	{
+		fprintf(stderr, "error: socket path too long: \"%s\"\n", socketPath);
+		return 1;
+	}
+	strcpy(addr.sun_path, socketPath);
+
+	int listener = socket(AF_UNIX, SOCK_STREAM, 0);
+	if (listener < 0)
+	{
+		perror("socket");
+		return 1;
+	}
+	// a socket left behind by an earlier daemon is replaced, but nothing
+	// else is removed to make room for it
+	struct stat existing;
+	if (lstat(socketPath, &existing) == 0)
+	{
+		if (!S_ISSOCK(existing.st_mode))
+		{
+			fprintf(stderr, "error: \"%s\" exists and is not a socket\n", socketPath);
+			close(listener);
+			return 1;
+		}
+		unlink(socketPath);
+	}
+	if (bind(listener, (struct sockaddr *)&addr, sizeof(addr)) != 0 || listen(listener, 8) != 0)
+	{
+		fprintf(stderr, "error: cannot listen on \"%s\": %s\n", socketPath, strerror(errno));
+		close(listener);
+		return 1;
+	}
+	// a client that hangs up early must not kill the daemon
+	signal(SIGPIPE, SIG_IGN);
+
+	bool running = true;
+	while (running)
+	{
+		int client = accept(listener, NULL, NULL);
+		if (client < 0)
+		{
+			if (errno == EINTR)
+				continue;
+			perror("accept");
+			break;
+		}
+		std::string pending;
+		char buf[4096];
+		bool open = true;
+		while (open && running)
+		{
+			ssize_t n = read(client, buf, sizeof(buf));
+			if (n < 0 && errno == EINTR)
+				continue;
+			if (n <= 0)
+				break;
+			pending.append(buf, n);
+			size_t newline;
+			while (open && (newline = pending.find('\n')) != std::string::npos)
+			{
+				std::vector<std::string> words = splitRequest(pending.substr(0, newline));
+				pending.erase(0, newline + 1);
+				if (words.empty())
+					continue;
+				std::string response;
+				if (words[0] == "shutdown")
+				{
+					response = "ok";
+					running = false;
+				}
+				else
+				{
+					response = handler(words);
+				}
+				open = writeAll(client, response + "\n") && running;
+			}
+		}
+		close(client);
+	}
+	close(listener);
+	unlink(socketPath);
+	return 0;
+}
+
+#endif
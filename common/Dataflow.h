@@ -0,0 +1,272 @@
+#ifndef CS5218_DATAFLOW_H
+#define CS5218_DATAFLOW_H
+
+#include <cstdint>
+#include <vector>
+
+#include "llvm/ADT/BitVector.h"
+
+#include "BlockGraph.h"
+
+//======================================================================
+// Dataflow framework
+//======================================================================
+// The schedule every analysis here runs its fixpoint with, written once
+// and specialized per analysis at compile time: a solver is a template
+// over the analysis' Problem type, whose hooks are plain (non-virtual)
+// member functions, so each instantiation inlines its own transfer and
+// join into the loops below.
+//
+// The states form a Lattice, a class of static members over its State:
+//
+//     static void join(State &into, const State &other)   into = into join other
+//     static void meet(State &into, const State &other)   into = into meet other
+//     static bool leq(const State &a, const State &b)      a below b
+//     static void widen(State &prev, const State &next)    prev = prev widened by next
+//
+// BitSetLattice and WordSetLattice below are the subsets of a fixed set;
+// FlatIntervalLattice (FlatIntervalState.h) holds intervals.
+//
+// A Problem derives from dataflow::Problem<Derived, Lattice, Direction> and
+// provides
+//
+//     void input(unsigned b, State &in)          the boundary value a block's
+//                                                input starts from: the
+//                                                join's identity, the
+//                                                meet's top, or the block's
+//                                                own previous output
+//     void joinEdge(State &in, unsigned from,    combine the stored output of
+//                   unsigned slot)               from along one edge into in
+//                                                (slot indexes G.preds, or
+//                                                G.succs when backward)
+//     bool transfer(unsigned b, const State &in) apply b to in and merge the
+//                                                result into b's stored
+//                                                state; true when it changed
+//
+// and may hide the defaults of the base: selfDependent, done(),
+// beginSweep(), widenDelay(), or evaluate() itself when a block needs more
+// than input-join-transfer (memoization, tracing).
+//
+// Widening. A problem whose lattice has infinite ascending chains returns
+// a nonzero widenDelay(). Once a cyclic component has been swept that many
+// times, the sweeps widen at its widening points (the blocks a retreating
+// edge enters, so every cycle has one), and after it is stable as many
+// narrowing sweeps meet each result with the stored state, to recover
+// what the widening overshot. transfer() learns how to fold a new result
+// into the stored state from combine(), which follows the current mode.
+namespace dataflow
+{
+
+// Subsets of a fixed set of ids, ordered by inclusion; finite, so
+// widening is the join
+struct BitSetLattice
+{
+	typedef llvm::BitVector State;
+	static void join(State &into, const State &other) { into |= other; }
+	static void meet(State &into, const State &other) { into &= other; }
+	static bool leq(const State &a, const State &b)
+	{
+		State outside = a;
+		return !outside.reset(b).any();
+	}
+	static void widen(State &prev, const State &next) { prev |= next; }
+};
+
+// The same over plain 64-bit words, for states that pack several bits per
+// element (a word group per location)
+struct WordSetLattice
+{
+	typedef std::vector<uint64_t> State;
+	static void join(State &into, const State &other)
+	{
+		for (size_t w = 0; w < other.size(); w++)
+			into[w] |= other[w];
+	}
+	static void meet(State &into, const State &other)
+	{
+		for (size_t w = 0; w < other.size(); w++)
+			into[w] &= other[w];
+	}
+	static bool leq(const State &a, const State &b)
+	{
+		for (size_t w = 0; w < a.size(); w++)
+		{
+			if (a[w] & ~b[w])
+				return false;
+		}
+		return true;
+	}
+	static void widen(State &prev, const State &next) { join(prev, next); }
+};
+
+// How the current sweep folds new results into the stored states
+enum SweepMode
+{
+	ASCENDING, // join
+	WIDENING,  // widen at widening points, join elsewhere
+	NARROWING  // meet
+};
+
+// Whether b is entered by a retreating edge: one from a reachable block
+// not before it in reverse post-order
+inline bool isWideningPoint(const BlockGraph &G, unsigned b)
+{
+	for (const unsigned *pred = G.predBegin(b); pred != G.predEnd(b); ++pred)
+	{
+		if (G.rpoNumber[*pred] != BlockGraph::NOT_REACHABLE && G.rpoNumber[*pred] >= G.rpoNumber[b])
+			return true;
+	}
+	return false;
+}
+
+enum Direction
+{
+	FORWARD, // edges run from G.preds into a block
+	BACKWARD // edges run from G.succs into a block
+};
+
+template <class Derived, class LatticeT, Direction Dir = FORWARD>
+struct Problem
+{
+	typedef LatticeT Lattice;
+	typedef typename LatticeT::State State;
+	static const Direction direction = Dir;
+	// a block's input includes its own previous output, so even a block on
+	// no cycle is evaluated until it is stable
+	enum { selfDependent = false };
+
+	Problem() : mode(ASCENDING) {}
+
+	// stop the solver early (a query already has its answer)
+	bool done() const { return false; }
+	// called before every pass over the blocks of a component
+	void beginSweep(unsigned c) {}
+	// sweeps of a cyclic component before it widens; 0 never widens (a
+	// finite lattice, or values that are clamped and so cannot climb far)
+	unsigned widenDelay() const { return 0; }
+
+	// set by solveScc before every sweep
+	SweepMode mode;
+
+	// Fold a new result for b into its stored state as the current sweep
+	// asks: result becomes the new stored state; true when it differs
+	// from stored
+	bool combine(const BlockGraph &G, unsigned b, State &result, const State &stored) const
+	{
+		if (mode == NARROWING)
+			Lattice::meet(result, stored);
+		else if (mode == WIDENING && isWideningPoint(G, b))
+		{
+			Lattice::join(result, stored);
+			State next = result;
+			result = stored;
+			Lattice::widen(result, next);
+		}
+		else
+			Lattice::join(result, stored);
+		return result != stored;
+	}
+
+	bool evaluate(const BlockGraph &G, unsigned b)
+	{
+		Derived &self = static_cast<Derived &>(*this);
+		State &in = scratch;
+		self.input(b, in);
+		joinInputs(self, G, b, in);
+		return self.transfer(b, in);
+	}
+
+	// Join the stored output of every block with an edge into b
+	template <class P>
+	static void joinInputs(P &problem, const BlockGraph &G, unsigned b, State &in)
+	{
+		if (direction == FORWARD)
+		{
+			for (unsigned slot = G.predOffset[b]; slot != G.predOffset[b + 1]; slot++)
+				problem.joinEdge(in, G.preds[slot], slot);
+		}
+		else
+		{
+			for (unsigned slot = G.succOffset[b]; slot != G.succOffset[b + 1]; slot++)
+				problem.joinEdge(in, G.succs[slot], slot);
+		}
+	}
+
+  private:
+	// the input being built, reused between evaluations
+	State scratch;
+};
+
+// One sweep over component c: blocks in reverse post-order, or in
+// post-order for a backward problem; true when any changed
+template <class P>
+bool sweepScc(P &problem, const BlockGraph &G, unsigned c)
+{
+	problem.beginSweep(c);
+	bool changed = false;
+	for (unsigned i = 0, n = G.sccEnd(c) - G.sccBegin(c); i < n && !problem.done(); i++)
+	{
+		unsigned b = P::direction == FORWARD ? G.sccBegin(c)[i] : G.sccEnd(c)[-1 - (int)i];
+		changed |= problem.evaluate(G, b);
+	}
+	return changed;
+}
+
+// Solve component c of G: a component on no cycle is evaluated once
+// (unless the problem is selfDependent), a cyclic one is swept until none
+// of its blocks changes, widening and then narrowing when the problem
+// asks for it (see above). Returns the number of sweeps.
+template <class P>
+unsigned long solveScc(P &problem, const BlockGraph &G, unsigned c)
+{
+	unsigned long sweeps = 0;
+	unsigned delay = problem.widenDelay();
+	bool widened = false;
+	bool changed = true;
+	problem.mode = ASCENDING;
+	while (changed && !problem.done())
+	{
+		if (delay != 0 && sweeps >= delay && G.isCyclicScc(c))
+		{
+			problem.mode = WIDENING;
+			widened = true;
+		}
+		sweeps++;
+		changed = sweepScc(problem, G, c);
+		if (!G.isCyclicScc(c) && !P::selfDependent)
+			break;
+	}
+	problem.mode = NARROWING;
+	for (unsigned k = 0; widened && k < delay && !problem.done(); k++)
+	{
+		sweeps++;
+		if (!sweepScc(problem, G, c))
+			break;
+	}
+	problem.mode = ASCENDING;
+	return sweeps;
+}
+
+// Solve G one component at a time, in topological order (reversed for a
+// backward problem), so every edge from outside a component carries its
+// final value by the time the component is entered
+template <class P>
+void solveBySccs(P &problem, const BlockGraph &G)
+{
+	for (unsigned i = 0; i < G.numSccs() && !problem.done(); i++)
+		solveScc(problem, G, P::direction == FORWARD ? i : G.numSccs() - 1 - i);
+}
+
+// One pass over every block in function order; true when any changed
+template <class P>
+bool sweep(P &problem, const BlockGraph &G)
+{
+	bool changed = false;
+	for (unsigned b = 0; b < G.size() && !problem.done(); b++)
+		changed |= problem.evaluate(G, b);
+	return changed;
+}
+
+} // namespace dataflow
+
+#endif
@@ -0,0 +1,352 @@
+#ifndef CS5218_FLAT_INTERVAL_STATE_H
+#define CS5218_FLAT_INTERVAL_STATE_H
+
+#include <climits>
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <string>
+#include <vector>
+
+#if defined(__AVX2__) || defined(__SSE4_1__)
+#include <immintrin.h>
+#endif
+
+//======================================================================
+// Flat interval states
+//======================================================================
+// A whole-function state as two contiguous arrays, lower[] and upper[],
+// indexed by variable id, so join, meet, widening and equality are single
+// passes over memory instead of walks over map nodes. A variable without
+// an interval (not in the state) has the bounds ABSENT_LOWER and
+// ABSENT_UPPER, which are neutral for join (min of lowers, max of uppers)
+// and absorbing for meet, so none of the kernels needs a separate flag.
+// The transfer functions (IntervalAnalysis.h) work on this form too, over
+// the ids interned when the function is decoded, so a block's evaluation
+// never leaves it.
+//
+// The kernels are vectorized with AVX2 when the tool is built with -mavx2
+// (or -march=native on a machine that has it), with SSE4.1 under -msse4.1,
+// and fall back to plain loops otherwise.
+
+// Dense ids for variable names, in order of first intern()
+class VariableTable
+{
+  public:
+	std::vector<std::string> names;
+
+	unsigned intern(const std::string &name)
+	{
+		std::map<std::string, unsigned>::iterator it = ids.find(name);
+		if (it != ids.end())
+			return it->second;
+		ids[name] = names.size();
+		names.push_back(name);
+		return names.size() - 1;
+	}
+	// NOT_FOUND for a name that was never interned
+	enum { NOT_FOUND = ~0u };
+	unsigned lookup(const std::string &name) const
+	{
+		std::map<std::string, unsigned>::const_iterator it = ids.find(name);
+		return it == ids.end() ? (unsigned)NOT_FOUND : it->second;
+	}
+	unsigned size() const { return names.size(); }
+	void clear()
+	{
+		names.clear();
+		ids.clear();
+	}
+
+  private:
+	std::map<std::string, unsigned> ids;
+};
+
+namespace flatkernels
+{
+
+const int32_t ABSENT_LOWER = INT32_MAX;
+const int32_t ABSENT_UPPER = INT32_MIN;
+
+// lo[i] = min(lo[i], otherLo[i]), hi[i] = max(hi[i], otherHi[i])
+inline void join(int32_t *lo, int32_t *hi, const int32_t *otherLo, const int32_t *otherHi, size_t n)
+{
+	size_t i = 0;
+#if defined(__AVX2__)
+	for (; i + 8 <= n; i += 8)
+	{
+		__m256i l = _mm256_min_epi32(_mm256_loadu_si256((const __m256i *)(lo + i)), _mm256_loadu_si256((const __m256i *)(otherLo + i)));
+		__m256i h = _mm256_max_epi32(_mm256_loadu_si256((const __m256i *)(hi + i)), _mm256_loadu_si256((const __m256i *)(otherHi + i)));
+		_mm256_storeu_si256((__m256i *)(lo + i), l);
+		_mm256_storeu_si256((__m256i *)(hi + i), h);
+	}
+#elif defined(__SSE4_1__)
+	for (; i + 4 <= n; i += 4)
+	{
+		__m128i l = _mm_min_epi32(_mm_loadu_si128((const __m128i *)(lo + i)), _mm_loadu_si128((const __m128i *)(otherLo + i)));
+		__m128i h = _mm_max_epi32(_mm_loadu_si128((const __m128i *)(hi + i)), _mm_loadu_si128((const __m128i *)(otherHi + i)));
+		_mm_storeu_si128((__m128i *)(lo + i), l);
+		_mm_storeu_si128((__m128i *)(hi + i), h);
+	}
+#endif
+	for (; i < n; i++)
+	{
+		if (otherLo[i] < lo[i])
+			lo[i] = otherLo[i];
+		if (otherHi[i] > hi[i])
+			hi[i] = otherHi[i];
+	}
+}
+
+// Intersection; a variable whose bounds cross becomes absent
+inline void meet(int32_t *lo, int32_t *hi, const int32_t *otherLo, const int32_t *otherHi, size_t n)
+{
+	size_t i = 0;
+#if defined(__AVX2__)
+	const __m256i absentLo = _mm256_set1_epi32(ABSENT_LOWER);
+	const __m256i absentHi = _mm256_set1_epi32(ABSENT_UPPER);
+	for (; i + 8 <= n; i += 8)
+	{
+		__m256i l = _mm256_max_epi32(_mm256_loadu_si256((const __m256i *)(lo + i)), _mm256_loadu_si256((const __m256i *)(otherLo + i)));
+		__m256i h = _mm256_min_epi32(_mm256_loadu_si256((const __m256i *)(hi + i)), _mm256_loadu_si256((const __m256i *)(otherHi + i)));
+		__m256i crossed = _mm256_cmpgt_epi32(l, h);
+		_mm256_storeu_si256((__m256i *)(lo + i), _mm256_blendv_epi8(l, absentLo, crossed));
+		_mm256_storeu_si256((__m256i *)(hi + i), _mm256_blendv_epi8(h, absentHi, crossed));
+	}
+#elif defined(__SSE4_1__)
+	const __m128i absentLo = _mm_set1_epi32(ABSENT_LOWER);
+	const __m128i absentHi = _mm_set1_epi32(ABSENT_UPPER);
+	for (; i + 4 <= n; i += 4)
+	{
+		__m128i l = _mm_max_epi32(_mm_loadu_si128((const __m128i *)(lo + i)), _mm_loadu_si128((const __m128i *)(otherLo + i)));
+		__m128i h = _mm_min_epi32(_mm_loadu_si128((const __m128i *)(hi + i)), _mm_loadu_si128((const __m128i *)(otherHi + i)));
+		__m128i crossed = _mm_cmpgt_epi32(l, h);
+		_mm_storeu_si128((__m128i *)(lo + i), _mm_blendv_epi8(l, absentLo, crossed));
+		_mm_storeu_si128((__m128i *)(hi + i), _mm_blendv_epi8(h, absentHi, crossed));
+	}
+#endif
+	for (; i < n; i++)
+	{
+		int32_t l = otherLo[i] > lo[i] ? otherLo[i] : lo[i];
+		int32_t h = otherHi[i] < hi[i] ? otherHi[i] : hi[i];
+		if (l > h)
+		{
+			l = ABSENT_LOWER;
+			h = ABSENT_UPPER;
+		}
+		lo[i] = l;
+		hi[i] = h;
+	}
+}
+
+// Standard interval widening of lo/hi by next: a bound that moved outward
+// jumps to negInf/posInf. A variable absent before takes next's bounds; one
+// absent in next keeps its own, since ABSENT_LOWER never lies below and
+// ABSENT_UPPER never above a bound.
+inline void widen(int32_t *lo, int32_t *hi, const int32_t *nextLo, const int32_t *nextHi, size_t n, int32_t negInf, int32_t posInf)
+{
+	size_t i = 0;
+#if defined(__AVX2__)
+	const __m256i vNegInf = _mm256_set1_epi32(negInf);
+	const __m256i vPosInf = _mm256_set1_epi32(posInf);
+	const __m256i absentLo = _mm256_set1_epi32(ABSENT_LOWER);
+	for (; i + 8 <= n; i += 8)
+	{
+		__m256i l = _mm256_loadu_si256((const __m256i *)(lo + i));
+		__m256i h = _mm256_loadu_si256((const __m256i *)(hi + i));
+		__m256i nl = _mm256_loadu_si256((const __m256i *)(nextLo + i));
+		__m256i nh = _mm256_loadu_si256((const __m256i *)(nextHi + i));
+		__m256i wl = _mm256_blendv_epi8(l, vNegInf, _mm256_cmpgt_epi32(l, nl));
+		__m256i wh = _mm256_blendv_epi8(h, vPosInf, _mm256_cmpgt_epi32(nh, h));
+		__m256i wasAbsent = _mm256_cmpeq_epi32(l, absentLo);
+		_mm256_storeu_si256((__m256i *)(lo + i), _mm256_blendv_epi8(wl, nl, wasAbsent));
+		_mm256_storeu_si256((__m256i *)(hi + i), _mm256_blendv_epi8(wh, nh, wasAbsent));
+	}
+#elif defined(__SSE4_1__)
+	const __m128i vNegInf = _mm_set1_epi32(negInf);
+	const __m128i vPosInf = _mm_set1_epi32(posInf);
+	const __m128i absentLo = _mm_set1_epi32(ABSENT_LOWER);
+	for (; i + 4 <= n; i += 4)
+	{
+		__m128i l = _mm_loadu_si128((const __m128i *)(lo + i));
+		__m128i h = _mm_loadu_si128((const __m128i *)(hi + i));
+		__m128i nl = _mm_loadu_si128((const __m128i *)(nextLo + i));
+		__m128i nh = _mm_loadu_si128((const __m128i *)(nextHi + i));
+		__m128i wl = _mm_blendv_epi8(l, vNegInf, _mm_cmpgt_epi32(l, nl));
+		__m128i wh = _mm_blendv_epi8(h, vPosInf, _mm_cmpgt_epi32(nh, h));
+		__m128i wasAbsent = _mm_cmpeq_epi32(l, absentLo);
+		_mm_storeu_si128((__m128i *)(lo + i), _mm_blendv_epi8(wl, nl, wasAbsent));
+		_mm_storeu_si128((__m128i *)(hi + i), _mm_blendv_epi8(wh, nh, wasAbsent));
+	}
+#endif
+	for (; i < n; i++)
+	{
+		if (lo[i] == ABSENT_LOWER)
+		{
+			lo[i] = nextLo[i];
+			hi[i] = nextHi[i];
+			continue;
+		}
+		if (nextLo[i] < lo[i])
+			lo[i] = negInf;
+		if (nextHi[i] > hi[i])
+			hi[i] = posInf;
+	}
+}
+
+inline bool equal(const int32_t *a, const int32_t *b, size_t n)
+{
+	size_t i = 0;
+#if defined(__AVX2__)
+	for (; i + 8 <= n; i += 8)
+	{
+		__m256i eq = _mm256_cmpeq_epi32(_mm256_loadu_si256((const __m256i *)(a + i)), _mm256_loadu_si256((const __m256i *)(b + i)));
+		if (_mm256_movemask_epi8(eq) != -1)
+			return false;
+	}
+#elif defined(__SSE4_1__)
+	for (; i + 4 <= n; i += 4)
+	{
+		__m128i eq = _mm_cmpeq_epi32(_mm_loadu_si128((const __m128i *)(a + i)), _mm_loadu_si128((const __m128i *)(b + i)));
+		if (_mm_movemask_epi8(eq) != 0xffff)
+			return false;
+	}
+#endif
+	for (; i < n; i++)
+	{
+		if (a[i] != b[i])
+			return false;
+	}
+	return true;
+}
+
+} // namespace flatkernels
+
+class FlatIntervalState
+{
+  public:
+	std::vector<int32_t> lower;
+	std::vector<int32_t> upper;
+
+	explicit FlatIntervalState(unsigned numVars = 0)
+		: lower(numVars, flatkernels::ABSENT_LOWER), upper(numVars, flatkernels::ABSENT_UPPER) {}
+
+	unsigned size() const { return lower.size(); }
+	// new variables are absent
+	void resize(unsigned numVars)
+	{
+		lower.resize(numVars, flatkernels::ABSENT_LOWER);
+		upper.resize(numVars, flatkernels::ABSENT_UPPER);
+	}
+	bool has(unsigned id) const { return id < lower.size() && lower[id] != flatkernels::ABSENT_LOWER; }
+	// no variable present: the state of a block no path reaches
+	bool isEmpty() const
+	{
+		for (unsigned i = 0; i < size(); i++)
+		{
+			if (has(i))
+				return false;
+		}
+		return true;
+	}
+	void set(unsigned id, int32_t lo, int32_t hi)
+	{
+		if (id >= size())
+			resize(id + 1);
+		lower[id] = lo;
+		upper[id] = hi;
+	}
+	void erase(unsigned id)
+	{
+		if (id < size())
+		{
+			lower[id] = flatkernels::ABSENT_LOWER;
+			upper[id] = flatkernels::ABSENT_UPPER;
+		}
+	}
+	// every variable absent, keeping the size
+	void clear()
+	{
+		lower.assign(lower.size(), flatkernels::ABSENT_LOWER);
+		upper.assign(upper.size(), flatkernels::ABSENT_UPPER);
+	}
+
+	void joinWith(const FlatIntervalState &other)
+	{
+		matchSize(other);
+		flatkernels::join(lower.data(), upper.data(), other.lower.data(), other.upper.data(), other.size());
+	}
+	void meetWith(const FlatIntervalState &other)
+	{
+		matchSize(other);
+		flatkernels::meet(lower.data(), upper.data(), other.lower.data(), other.upper.data(), other.size());
+		// variables other does not have at all are absent from the meet
+		for (unsigned i = other.size(); i < size(); i++)
+			erase(i);
+	}
+	void widenWith(const FlatIntervalState &next, int32_t negInf, int32_t posInf)
+	{
+		matchSize(next);
+		flatkernels::widen(lower.data(), upper.data(), next.lower.data(), next.upper.data(), next.size(), negInf, posInf);
+	}
+	// states of different sizes are equal when the extra variables are absent
+	bool operator==(const FlatIntervalState &other) const
+	{
+		unsigned common = size() < other.size() ? size() : other.size();
+		if (!flatkernels::equal(lower.data(), other.lower.data(), common) || !flatkernels::equal(upper.data(), other.upper.data(), common))
+			return false;
+		for (unsigned i = common; i < size(); i++)
+		{
+			if (has(i))
+				return false;
+		}
+		for (unsigned i = common; i < other.size(); i++)
+		{
+			if (other.has(i))
+				return false;
+		}
+		return true;
+	}
+	bool operator!=(const FlatIntervalState &other) const { return !(*this == other); }
+
+	// FNV-1a over the present variables' ids and bounds
+	uint64_t hash() const
+	{
+		uint64_t h = 14695981039346656037ULL;
+		for (unsigned i = 0; i < size(); i++)
+		{
+			if (!has(i))
+				continue;
+			h = (h ^ i) * 1099511628211ULL;
+			h = (h ^ (uint32_t)lower[i]) * 1099511628211ULL;
+			h = (h ^ (uint32_t)upper[i]) * 1099511628211ULL;
+		}
+		return h;
+	}
+
+  private:
+	void matchSize(const FlatIntervalState &other)
+	{
+		if (size() < other.size())
+			resize(other.size());
+	}
+};
+
+// Flat interval states as a dataflow lattice (see Dataflow.h): a bound
+// that moved outward widens to NegInf or PosInf
+template <int32_t NegInf, int32_t PosInf>
+struct FlatIntervalLattice
+{
+	typedef FlatIntervalState State;
+	static void join(State &into, const State &other) { into.joinWith(other); }
+	static void meet(State &into, const State &other) { into.meetWith(other); }
+	static bool leq(const State &a, const State &b)
+	{
+		State joined = b;
+		joined.joinWith(a);
+		return joined == b;
+	}
+	static void widen(State &prev, const State &next) { prev.widenWith(next, NegInf, PosInf); }
+};
+
+#endif
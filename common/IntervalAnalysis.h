@@ -0,0 +1,999 @@
+#ifndef CS5218_INTERVAL_ANALYSIS_H
+#define CS5218_INTERVAL_ANALYSIS_H
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "llvm/ADT/DenseSet.h"
+#include "llvm/IR/BasicBlock.h"
+#include "llvm/IR/Constants.h"
+#include "llvm/IR/InstrTypes.h"
+#include "llvm/IR/Instructions.h"
+#include "llvm/Support/raw_ostream.h"
+
+#include "AnalysisStats.h"
+#include "Arena.h"
+#include "BlockGraph.h"
+#include "ConvergenceProfile.h"
+#include "Dataflow.h"
+#include "FlatIntervalState.h"
+#include "PrePass.h"
+#include "StateSpill.h"
+#include "Trace.h"
+
+//======================================================================
+// Interval analysis
+//======================================================================
+// The analysis both parts of Assignment 3 run on main: the interval of
+// every variable at the end of each block, clamped to [NEG_INF, POS_INF].
+// IntervalProblem is its dataflow problem (see Dataflow.h) together with
+// everything around the fixpoint: transfer memoization, liveness of
+// temporaries, the --memory-budget spill of the stored states, the
+// --trace and --profile-dot hooks, and the options that set them.
+//
+// It is a template over the tool's own problem type, which derives from
+// it and may hide these hooks to change what a block sees:
+//
+//     void joinEdge(FlatIntervalState &in,      join the stored state of
+//                   unsigned from,               from into in, when from is
+//                   unsigned slot)               active (part2 first refines
+//                                                it by the branch on the edge)
+//     void refineInput(unsigned b,              adjust b's joined input
+//                      FlatIntervalState &in)    before its transfer
+//     bool evaluatesBlock(unsigned b)           whether b and I are evaluated
+//     bool evaluatesInstruction(I)              at all (a query's slice)
+//     void gatherPredecessor(G, pred)           called for every active
+//                                                predecessor a block gathers
+//     unsigned long solveComponent(G, c, span)  solve component c (part2
+//                                                accelerates counting loops)
+//     void prepare(const BlockGraph &G)         build per-function tables,
+//                                                once per function
+//
+// and startsActive, whether the first round of --schedule=rounds gathers
+// every predecessor or none.
+
+const static int POS_INF = 1000;
+const static int NEG_INF = -1000;
+
+// Every tool names variables through its own getSimpleVarName().
+std::string getSimpleVarName(const llvm::Instruction *Ins);
+
+class Interval
+{
+  public:
+	int lower;
+	int upper;
+	bool empty;
+	Interval() { empty = true; }
+	Interval(int lower, int upper)
+	{
+		if (lower <= NEG_INF)
+			this->lower = NEG_INF;
+		else if (lower >= POS_INF)
+			this->lower = POS_INF;
+		else
+			this->lower = lower;
+
+		if (upper >= POS_INF)
+			this->upper = POS_INF;
+		else if (upper <= NEG_INF)
+			this->upper = NEG_INF;
+		else
+			this->upper = upper;
+		empty = false;
+	}
+	bool isEmpty() const
+	{
+		return this->empty;
+	}
+	int getUpper() const
+	{
+		return this->upper;
+	}
+	int getLower() const
+	{
+		return this->lower;
+	}
+	void setLower(int lower)
+	{
+		if (lower <= NEG_INF)
+			this->lower = NEG_INF;
+		else if (lower >= POS_INF)
+			this->lower = POS_INF;
+		else
+			this->lower = lower;
+	}
+	void setUpper(int upper)
+	{
+		if (upper >= POS_INF)
+			this->upper = POS_INF;
+		else if (upper <= NEG_INF)
+			this->upper = NEG_INF;
+		else
+			this->upper = upper;
+	}
+	bool operator==(const Interval &a) const
+	{
+		return (a.lower == this->lower && a.upper == this->upper);
+	}
+	bool operator!=(const Interval &a) const
+	{
+		return (a.lower != this->lower || a.upper != this->upper);
+	}
+	std::string toString() const
+	{
+		return "[ " + (this->getLower() == NEG_INF ? "NEG_INF" : std::to_string(this->getLower())) + " , " +
+			   (this->getUpper() == POS_INF ? "POS_INF" : std::to_string(this->getUpper())) + " ]";
+	}
+};
+
+//======================================================================
+// Decoded instructions
+//======================================================================
+// Every instruction the transfer functions handle is decoded once per
+// function, before the fixpoint: its opcode, and the variable ids of what
+// it writes and reads, interned from the names the analysis reports. A
+// block's evaluation then runs its IntervalOps on the flat state directly,
+// without looking a name up.
+struct IntervalOperand
+{
+	bool isConstant;
+	int64_t value; // the constant
+	unsigned id;   // the variable, VariableTable::NOT_FOUND when it never has an interval
+	IntervalOperand() : isConstant(false), value(0), id(VariableTable::NOT_FOUND) {}
+};
+
+struct IntervalOp
+{
+	// Alloca, Store, Load, Add, Sub, Mul, SDiv or SRem
+	unsigned opcode;
+	const llvm::Instruction *inst;
+	// the variable written: the alloca, the address stored to, the value
+	unsigned result;
+	// the stored value, the loaded address, or the operands
+	IntervalOperand lhs;
+	IntervalOperand rhs;
+};
+
+//======================================================================
+// Transfer memoization
+//======================================================================
+// The output of a block only depends on the union of its active
+// predecessors (as joinEdge() passes them on), so every block remembers a
+// fingerprint of the input it was last evaluated on. The fingerprint has
+// two levels: the (active, version) stamp of each predecessor, which is
+// checked before building the union at all, and a copy of the union
+// itself for when a predecessor changed but the joined input did not,
+// compared only when its hash matches. Under --memory-budget no copy is
+// kept, so that the inputs do not double the resident states, and only
+// stamps hit. On a hit both the transfer and the merge into the stored
+// state are skipped, because the same input would produce the same output
+// that is already merged into blockStates.
+struct InputFingerprint
+{
+	bool valid;
+	std::vector<std::pair<bool, unsigned> > predStamps;
+	uint64_t hash;
+	FlatIntervalState input;
+	InputFingerprint() : valid(false), hash(0) {}
+};
+
+// The options both tools take (see their main()), as far as they are not
+// settings of the problem itself
+struct IntervalOptions
+{
+	const char *inputFile;
+	bool memoStats;
+	bool writeStats;
+	const char *statsFile;
+	const char *traceFile;
+	const char *profileFile;
+	PrePassOptions prePasses;
+	IntervalOptions() : inputFile(nullptr), memoStats(false), writeStats(false), statsFile(nullptr), traceFile(nullptr), profileFile(nullptr) {}
+};
+
+enum OptionStatus
+{
+	OPTION_TAKEN,
+	OPTION_UNKNOWN, // left to the tool
+	OPTION_INVALID	// an error was printed
+};
+
+template <class Tool>
+class IntervalProblem : public dataflow::Problem<Tool, FlatIntervalLattice<NEG_INF, POS_INF> >
+{
+  public:
+	typedef FlatIntervalLattice<NEG_INF, POS_INF> Lattice;
+	typedef dataflow::Problem<Tool, Lattice> Base;
+	enum { startsActive = false };
+
+	// Solve component by component (solveBySccs) instead of sweeping the
+	// whole function until nothing changes
+	bool sccSchedule;
+	// --widen=N: sweeps of a loop before its intervals widen (0: they climb
+	// until the clamp to [NEG_INF, POS_INF] stops them)
+	unsigned widenSweeps;
+	// --memory-budget: every access to blockStates goes through spill.touch()
+	StateSpill spill;
+
+	// Stored state of every block, indexed by BlockGraph id, over the ids
+	// in variables: the fixpoint runs on these, and the results are read
+	// from them (see result()). Ids from liveVariables on are temporaries
+	// that die in their block, which no stored state holds.
+	VariableTable variables;
+	unsigned liveVariables;
+	std::vector<FlatIntervalState> blockStates;
+	// scratch of each evaluation, reset before the next one
+	Arena scratchArena;
+	// active flag per BlockGraph id: the block changed in the last round,
+	// or follows one that did
+	std::vector<char> activeBlocks;
+
+	// indexed by BlockGraph id
+	std::vector<unsigned> blockVersion;
+	std::vector<InputFingerprint> blockFingerprint;
+	unsigned long memoLookups;
+	unsigned long memoStampHits;
+	unsigned long memoHashHits;
+
+	// A block's state also holds every loaded value and arithmetic result
+	// it computed. Those whose uses all sit in the defining block are dead
+	// once the block ends, so they are dropped from its output instead of
+	// being joined, compared and copied through the rest of the function.
+	// User variables are never dropped: each one is reported at every block.
+	std::vector<std::vector<unsigned> > deadTemporaries;
+	// the decoded instructions of every block
+	std::vector<std::vector<IntervalOp> > blockOps;
+
+	AnalysisStats &stats;
+	TraceRecorder &tracer;
+	ConvergenceProfile &profile;
+
+	IntervalProblem(AnalysisStats &stats, TraceRecorder &tracer, ConvergenceProfile &profile)
+		: sccSchedule(true), widenSweeps(0), liveVariables(0), memoLookups(0), memoStampHits(0), memoHashHits(0), stats(stats), tracer(tracer), profile(profile), prepared(false) {}
+
+	//==================================================================
+	// Hooks (see above)
+	//==================================================================
+	void joinEdge(FlatIntervalState &in, unsigned from, unsigned slot)
+	{
+		if (!activeBlocks[from])
+			return;
+		// in this way, we need to merge all the predecessor information
+		STATS_COUNT(stats, "join");
+		spill.touch(blockStates, from);
+		Lattice::join(in, blockStates[from]);
+	}
+	void refineInput(unsigned b, FlatIntervalState &in) {}
+	bool evaluatesBlock(unsigned b) const { return true; }
+	bool evaluatesInstruction(const llvm::Instruction *I) const { return true; }
+	void gatherPredecessor(const BlockGraph &G, unsigned pred) {}
+	unsigned long solveComponent(const BlockGraph &G, unsigned c, TraceSpan &span)
+	{
+		return dataflow::solveScc(tool(), G, c);
+	}
+	void prepare(const BlockGraph &G) {}
+
+	// dataflow::Problem
+	void beginSweep(unsigned c) { STATS_COUNT(stats, "scc_sweeps"); }
+	unsigned widenDelay() const { return widenSweeps; }
+
+	//==================================================================
+	// Solving
+	//==================================================================
+	// Decode G and build its per-function tables, unless that is done
+	// already: they are kept until clear(), so that solving G again (part2
+	// does for every slice) does not rebuild them
+	void prepareFunction(const BlockGraph &G)
+	{
+		if (prepared)
+			return;
+		blockStates.assign(G.size(), FlatIntervalState());
+		spill.reset(G.size());
+		blockVersion.assign(G.size(), 0);
+		blockFingerprint.assign(G.size(), InputFingerprint());
+		activeBlocks.assign(G.size(), Tool::startsActive);
+		decode(G);
+		tool().prepare(G);
+		prepared = true;
+	}
+
+	// Solve the intervals of every block of G into blockStates; initPhase
+	// is stopped once the per-function tables are built. When G was solved
+	// before, only the blocks this solve evaluates start over; the others
+	// are neither read nor touched.
+	void solve(const BlockGraph &G, StatsPhase &initPhase)
+	{
+		currentArena() = &scratchArena;
+		if (prepared)
+		{
+			for (unsigned b = 0; b < G.size(); b++)
+			{
+				if (tool().evaluatesBlock(b))
+					forgetBlock(b);
+			}
+		}
+		else
+			prepareFunction(G);
+		initPhase.stop();
+
+		// Keeping a snapshot of the previous ananlysis
+		std::vector<FlatIntervalState> oldStates;
+		// Fixpoint Loop
+		StatsPhase fixpointPhase(stats, "fixpoint");
+		if (sccSchedule)
+			solveBySccs(G);
+		else
+		{
+			unsigned long round = 0;
+			while (!fixPointReached(oldStates, G))
+			{
+				STATS_COUNT(stats, "fixpoint_rounds");
+				TraceSpan roundSpan(tracer, "round", "fixpoint round");
+				roundSpan.arg("round", ++round);
+				oldStates = blockStates;
+				dataflow::sweep(tool(), G);
+				activeBlocks.assign(G.size(), 0);
+			}
+		}
+		fixpointPhase.stop();
+		stats.set("variables", liveVariables);
+	}
+
+	// Forget every result so another function can be solved
+	void clear()
+	{
+		blockStates.clear();
+		variables.clear();
+		liveVariables = 0;
+		blockVersion.clear();
+		blockFingerprint.clear();
+		deadTemporaries.clear();
+		blockOps.clear();
+		activeBlocks.clear();
+		scratchArena.reset();
+		prepared = false;
+	}
+
+	// Drop block b's stored state, freeing its arrays, and the input it
+	// was evaluated on
+	void forgetBlock(unsigned b)
+	{
+		spill.touch(blockStates, b);
+		blockStates[b] = FlatIntervalState();
+		spill.charge(blockStates, b);
+		blockFingerprint[b] = InputFingerprint();
+		blockVersion[b]++;
+		activeBlocks[b] = Tool::startsActive;
+	}
+
+	// Evaluate block b on the join of its active predecessors and merge
+	// the result into its stored state; true when that changed
+	bool evaluate(const BlockGraph &G, unsigned b)
+	{
+		Tool &self = tool();
+		if (!self.evaluatesBlock(b))
+			return false;
+		// nothing from the previous block's evaluation is alive any more
+		scratchArena.reset();
+		TraceSpan blockSpan(tracer, "block", G.labels[b]);
+		InputFingerprint &fingerprint = blockFingerprint[b];
+		ArenaVector<std::pair<bool, unsigned> > predStamps;
+		predStamps.reserve(G.numPreds(b));
+		for (const unsigned *pred = G.predBegin(b); pred != G.predEnd(b); ++pred)
+		{
+			if (activeBlocks[*pred])
+			{
+				self.gatherPredecessor(G, *pred);
+				predStamps.push_back(std::make_pair(true, blockVersion[*pred]));
+			}
+			else
+				predStamps.push_back(std::make_pair(false, 0u));
+		}
+		memoLookups++;
+		// a narrowing sweep meets instead of joining, so an unchanged input
+		// can still lower the stored state
+		bool memoize = this->mode != dataflow::NARROWING;
+		if (memoize && fingerprint.valid && fingerprint.predStamps.size() == predStamps.size() &&
+			std::equal(predStamps.begin(), predStamps.end(), fingerprint.predStamps.begin()))
+		{
+			memoStampHits++;
+			blockSpan.arg("memo", "stamp");
+			if (profile.isEnabled())
+				profile.recordSkip(b);
+			return false;
+		}
+		fingerprint.predStamps.assign(predStamps.begin(), predStamps.end());
+
+		predUnion.clear();
+		// Load the current stored analysis for all predecessor nodes
+		Base::joinInputs(self, G, b, predUnion);
+		self.refineInput(b, predUnion);
+		uint64_t inputHash = predUnion.hash();
+		// the hash only rules inputs out; a match is confirmed on the copy
+		if (memoize && fingerprint.valid && !spill.isEnabled() && fingerprint.hash == inputHash && fingerprint.input == predUnion)
+		{
+			memoHashHits++;
+			blockSpan.arg("memo", "hash");
+			if (profile.isEnabled())
+				profile.recordSkip(b);
+			return false;
+		}
+		fingerprint.valid = true;
+		fingerprint.hash = inputHash;
+		if (!spill.isEnabled())
+			fingerprint.input = predUnion;
+
+		if (profile.isEnabled())
+			profile.recordEvaluation(b);
+		// the transfer runs in place: from here on predUnion is b's result
+		applyBlock(b, predUnion);
+		spill.touch(blockStates, b);
+		FlatIntervalState &OldBBAnalysis = blockStates[b];
+		STATS_COUNT(stats, "state_compare");
+		if (predUnion != OldBBAnalysis)
+		{
+			STATS_COUNT(stats, "join");
+			bool grew = this->combine(G, b, predUnion, OldBBAnalysis);
+			if (profile.isEnabled())
+				profileChange(b, OldBBAnalysis, predUnion);
+			// copied rather than swapped: predUnion has room for every
+			// temporary, which the stored state must not keep resident
+			OldBBAnalysis.lower.assign(predUnion.lower.begin(), predUnion.lower.end());
+			OldBBAnalysis.upper.assign(predUnion.upper.begin(), predUnion.upper.end());
+			spill.charge(blockStates, b);
+			blockVersion[b]++;
+			blockSpan.arg("changed", 1ul);
+			return grew;
+		}
+		return false;
+	}
+
+	// Fixpoint over the SCC condensation of G: components are solved one
+	// after another in topological order, so every predecessor outside a
+	// component is final before the component is entered. A block on no
+	// cycle is evaluated once; a cyclic component is swept in reverse
+	// post-order until none of its blocks changes. Every predecessor counts
+	// as active, since the ones not yet solved are still empty.
+	void solveBySccs(const BlockGraph &G)
+	{
+		activeBlocks.assign(G.size(), 1);
+		for (unsigned c = 0; c < G.numSccs(); c++)
+		{
+			if (!evaluatesComponent(G, c))
+				continue;
+			TraceSpan sccSpan(tracer, "scc", G.labels[*G.sccBegin(c)]);
+			sccSpan.arg("blocks", (unsigned long)(G.sccEnd(c) - G.sccBegin(c)));
+			unsigned long sweeps = tool().solveComponent(G, c, sccSpan);
+			sccSpan.arg("sweeps", sweeps);
+		}
+		stats.set("sccs", G.numSccs());
+	}
+
+	// Whether no block changed since oldStates was taken; the ones that
+	// did, and their successors, become active for the next round
+	bool fixPointReached(const std::vector<FlatIntervalState> &oldStates, const BlockGraph &G)
+	{
+		bool result = true;
+		if (oldStates.empty())
+			result = false;
+		FlatIntervalState emptySet;
+		for (unsigned b = 0; b < G.size(); b++)
+		{
+			STATS_COUNT(stats, "state_compare");
+			if (blockStates[b] != (oldStates.empty() ? emptySet : oldStates[b]))
+			{
+				result = false;
+				activeBlocks[b] = 1;
+				// add this block successor to the activeblock
+				for (const unsigned *succ = G.succBegin(b); succ != G.succEnd(b); ++succ)
+					activeBlocks[*succ] = 1;
+			}
+		}
+		return result;
+	}
+
+	//==================================================================
+	// Transfer functions
+	//==================================================================
+	// Run the decoded instructions of block b on state, then drop the
+	// temporaries that die in b
+	void applyBlock(unsigned b, FlatIntervalState &state)
+	{
+		STATS_COUNT(stats, "blocks_evaluated");
+		const std::vector<IntervalOp> &ops = blockOps[b];
+		for (size_t i = 0; i < ops.size(); i++)
+		{
+			const IntervalOp &op = ops[i];
+			if (!tool().evaluatesInstruction(op.inst))
+				continue;
+			switch (op.opcode)
+			{
+			case llvm::Instruction::Alloca:
+				processAlloca(op, state);
+				break;
+			case llvm::Instruction::Store:
+				processStore(op, state);
+				break;
+			case llvm::Instruction::Load:
+				processLoad(op, state);
+				break;
+			case llvm::Instruction::Add:
+				processAdd(op, state);
+				break;
+			case llvm::Instruction::Sub:
+				processSub(op, state);
+				break;
+			case llvm::Instruction::Mul:
+				processMul(op, state);
+				break;
+			case llvm::Instruction::SDiv:
+				processDiv(op, state);
+				break;
+			case llvm::Instruction::SRem:
+				processRem(op, state);
+				break;
+			}
+		}
+		const std::vector<unsigned> &dead = deadTemporaries[b];
+		for (size_t i = 0; i < dead.size(); i++)
+			state.erase(dead[i]);
+		// every id from liveVariables on is one of those
+		if (state.size() > liveVariables)
+			state.resize(liveVariables);
+	}
+
+	//==================================================================
+	// Results
+	//==================================================================
+	// Once solve() is done the results are read from blockStates one block
+	// at a time, so that under --memory-budget no more of them are
+	// resident than during the fixpoint.
+
+	// The blocks of G in the order of their labels
+	std::vector<unsigned> blocksByLabel(const BlockGraph &G) const
+	{
+		std::vector<unsigned> order(G.size());
+		for (unsigned b = 0; b < G.size(); b++)
+			order[b] = b;
+		std::sort(order.begin(), order.end(), [&G](unsigned x, unsigned y) { return G.labels[x] < G.labels[y]; });
+		return order;
+	}
+
+	// The ids of the variables of the source program (the names without a
+	// '%'), in the order of their names
+	std::vector<unsigned> userVariables() const
+	{
+		std::vector<unsigned> ids;
+		for (unsigned id = 0; id < liveVariables; id++)
+		{
+			if (variables.names[id].find('%') == std::string::npos)
+				ids.push_back(id);
+		}
+		std::sort(ids.begin(), ids.end(), [this](unsigned x, unsigned y) { return variables.names[x] < variables.names[y]; });
+		return ids;
+	}
+
+	// The result of block b, valid until the next block is read
+	const FlatIntervalState &result(unsigned b)
+	{
+		spill.touch(blockStates, b);
+		return blockStates[b];
+	}
+
+	static Interval intervalOf(const FlatIntervalState &state, unsigned id)
+	{
+		return state.has(id) ? Interval(state.lower[id], state.upper[id]) : Interval();
+	}
+
+	//==================================================================
+	// Reporting
+	//==================================================================
+	void printMemoStats() const
+	{
+		unsigned long hits = memoStampHits + memoHashHits;
+		llvm::errs() << "Transfer memo: " << hits << " hits of " << memoLookups << " lookups ("
+					 << memoStampHits << " by stamp, " << memoHashHits << " by hash), hit rate "
+					 << (memoLookups ? (100 * hits / memoLookups) : 0) << "%\n";
+	}
+
+	// The counters --stats reports besides the ones counted on the way
+	void recordStats()
+	{
+		stats.set("memo_lookups", memoLookups);
+		stats.set("memo_stamp_hits", memoStampHits);
+		stats.set("memo_hash_hits", memoHashHits);
+		stats.set("arena_bytes", scratchArena.capacity());
+		if (spill.isEnabled())
+		{
+			stats.set("state_peak_bytes", spill.peakBytes());
+			stats.set("state_spills", spill.spillCount());
+			stats.set("state_reloads", spill.reloadCount());
+		}
+	}
+
+	//==================================================================
+	// Options
+	//==================================================================
+	// --memo-stats prints the transfer memoization hit rate,
+	// --stats[=file] writes run statistics as JSON (to stderr by default),
+	// --trace=file records the fixpoint iteration as a Chrome trace,
+	// --profile-dot=file draws the CFG colored by how often each block ran,
+	// --prepass=list simplifies the CFG first (see PrePass.h),
+	// --schedule=rounds sweeps the whole function instead of one SCC at a time,
+	// --memory-budget=size spills cold block states to disk (see StateSpill.h),
+	// --widen[=N] widens loops after N sweeps (2 by default) instead of
+	// letting the clamp stop them, then narrows (see Dataflow.h)
+	OptionStatus parseOption(const char *arg, IntervalOptions &options)
+	{
+		if (!strcmp(arg, "--memo-stats"))
+			options.memoStats = true;
+		else if (!strcmp(arg, "--stats"))
+			options.writeStats = true;
+		else if (!strncmp(arg, "--stats=", 8))
+		{
+			options.writeStats = true;
+			options.statsFile = arg + 8;
+		}
+		else if (!strncmp(arg, "--trace=", 8))
+			options.traceFile = arg + 8;
+		else if (!strncmp(arg, "--profile-dot=", 14))
+			options.profileFile = arg + 14;
+		else if (!strcmp(arg, "--schedule=rounds"))
+			sccSchedule = false;
+		else if (!strcmp(arg, "--schedule=scc"))
+			sccSchedule = true;
+		else if (!strcmp(arg, "--widen"))
+			widenSweeps = 2;
+		else if (!strncmp(arg, "--widen=", 8))
+		{
+			char *end;
+			unsigned long delay = strtoul(arg + 8, &end, 10);
+			if (*end != '\0' || delay == 0 || delay > 1000)
+			{
+				fprintf(stderr, "error: invalid widening delay \"%s\" (expected 1 to 1000 sweeps)\n", arg + 8);
+				return OPTION_INVALID;
+			}
+			widenSweeps = delay;
+		}
+		else if (!strncmp(arg, "--memory-budget=", 16))
+		{
+			size_t budget;
+			if (!parseByteSize(arg + 16, budget) || budget == 0)
+			{
+				fprintf(stderr, "error: invalid memory budget \"%s\" (expected a byte count, optionally with k, m or g)\n", arg + 16);
+				return OPTION_INVALID;
+			}
+			spill.enable(budget);
+		}
+		else if (!strncmp(arg, "--prepass=", 10))
+		{
+			if (!parsePrePasses(arg + 10, options.prePasses))
+				return OPTION_INVALID;
+		}
+		else
+			return OPTION_UNKNOWN;
+		return OPTION_TAKEN;
+	}
+
+	// false, after printing why, when the options cannot be combined
+	bool checkOptions() const
+	{
+		// the rounds schedule compares against a snapshot of every state
+		if (spill.isEnabled() && !sccSchedule)
+		{
+			fprintf(stderr, "error: --memory-budget needs --schedule=scc\n");
+			return false;
+		}
+		// widening points are found per component
+		if (widenSweeps != 0 && !sccSchedule)
+		{
+			fprintf(stderr, "error: --widen needs --schedule=scc\n");
+			return false;
+		}
+		return true;
+	}
+
+  protected:
+	Tool &tool() { return static_cast<Tool &>(*this); }
+
+  private:
+	// reused between evaluations, so its arrays are allocated once
+	FlatIntervalState predUnion;
+	// the per-function tables are built (see prepareFunction())
+	bool prepared;
+
+	// Whether any block of component c is evaluated at all
+	bool evaluatesComponent(const BlockGraph &G, unsigned c)
+	{
+		for (const unsigned *b = G.sccBegin(c); b != G.sccEnd(c); ++b)
+		{
+			if (tool().evaluatesBlock(*b))
+				return true;
+		}
+		return false;
+	}
+
+	//==================================================================
+	// Decoding
+	//==================================================================
+	// The variable I writes, if it is one the transfers handle
+	static const llvm::Instruction *writtenVariable(const llvm::Instruction &I)
+	{
+		switch (I.getOpcode())
+		{
+		case llvm::Instruction::Store:
+			return llvm::dyn_cast<llvm::Instruction>(I.getOperand(1));
+		case llvm::Instruction::Alloca:
+		case llvm::Instruction::Load:
+		case llvm::Instruction::Add:
+		case llvm::Instruction::Sub:
+		case llvm::Instruction::Mul:
+		case llvm::Instruction::SDiv:
+		case llvm::Instruction::SRem:
+			return &I;
+		}
+		return NULL;
+	}
+
+	// A loaded value or arithmetic result whose uses all sit in block b
+	static bool diesInBlock(const BlockGraph &G, unsigned b, const llvm::Instruction &I)
+	{
+		if (!llvm::isa<llvm::LoadInst>(I) && !llvm::isa<llvm::BinaryOperator>(I))
+			return false;
+		for (auto U = I.user_begin(); U != I.user_end(); ++U)
+		{
+			const llvm::Instruction *user = llvm::dyn_cast<llvm::Instruction>(*U);
+			if (user == nullptr || user->getParent() != G.blocks[b] || llvm::isa<llvm::PHINode>(user))
+				return false;
+		}
+		return true;
+	}
+
+	IntervalOperand decodeOperand(const llvm::Value *V) const
+	{
+		IntervalOperand operand;
+		if (const llvm::ConstantInt *CI = llvm::dyn_cast<llvm::ConstantInt>(V))
+		{
+			operand.isConstant = true;
+			operand.value = CI->getSExtValue();
+		}
+		else if (const llvm::Instruction *I = llvm::dyn_cast<llvm::Instruction>(V))
+			operand.id = variables.lookup(getSimpleVarName(I));
+		return operand;
+	}
+
+	// Intern the variables of G, the ones a stored state can hold first,
+	// then decode its instructions and dead temporaries over their ids
+	void decode(const BlockGraph &G)
+	{
+		llvm::DenseSet<const llvm::Instruction *> dying;
+		for (unsigned b = 0; b < G.size(); b++)
+		{
+			for (auto &I : *G.blocks[b])
+			{
+				if (diesInBlock(G, b, I))
+					dying.insert(&I);
+			}
+		}
+		for (int pass = 0; pass < 2; pass++)
+		{
+			for (unsigned b = 0; b < G.size(); b++)
+			{
+				for (auto &I : *G.blocks[b])
+				{
+					const llvm::Instruction *written = writtenVariable(I);
+					if (written != NULL && (pass == 1 || !dying.count(written)))
+						variables.intern(getSimpleVarName(written));
+				}
+			}
+			if (pass == 0)
+				liveVariables = variables.size();
+		}
+
+		blockOps.assign(G.size(), std::vector<IntervalOp>());
+		deadTemporaries.assign(G.size(), std::vector<unsigned>());
+		for (unsigned b = 0; b < G.size(); b++)
+		{
+			for (auto &I : *G.blocks[b])
+			{
+				const llvm::Instruction *written = writtenVariable(I);
+				if (written == NULL)
+					continue;
+				IntervalOp op;
+				op.opcode = I.getOpcode();
+				op.inst = &I;
+				op.result = variables.lookup(getSimpleVarName(written));
+				if (op.opcode == llvm::Instruction::Store)
+					op.lhs = decodeOperand(I.getOperand(0));
+				else if (op.opcode != llvm::Instruction::Alloca)
+				{
+					op.lhs = decodeOperand(I.getOperand(0));
+					if (op.opcode != llvm::Instruction::Load)
+						op.rhs = decodeOperand(I.getOperand(1));
+				}
+				blockOps[b].push_back(op);
+				if (dying.count(&I))
+					deadTemporaries[b].push_back(op.result);
+			}
+		}
+	}
+
+	// Record a change of block b's stored state and the variables it touched
+	void profileChange(unsigned b, const FlatIntervalState &before, const FlatIntervalState &after)
+	{
+		profile.recordChange(b);
+		for (unsigned id = 0; id < after.size(); id++)
+		{
+			if (after.has(id) && (!before.has(id) || before.lower[id] != after.lower[id] || before.upper[id] != after.upper[id]))
+				profile.recordChangedVar(b, variables.names[id]);
+		}
+	}
+
+	// The interval of operand in state; empty when it has none
+	static Interval extractInterval(const IntervalOperand &operand, const FlatIntervalState &state)
+	{
+		if (operand.isConstant)
+			return Interval(operand.value, operand.value);
+		if (!state.has(operand.id))
+			return Interval();
+		return Interval(state.lower[operand.id], state.upper[operand.id]);
+	}
+
+	static void assign(FlatIntervalState &state, unsigned id, const Interval &interval)
+	{
+		state.set(id, interval.getLower(), interval.getUpper());
+	}
+
+	// Processing Alloca Instruction
+	void processAlloca(const IntervalOp &op, FlatIntervalState &state)
+	{
+		STATS_COUNT(stats, "processAlloca");
+		assign(state, op.result, Interval(NEG_INF, POS_INF));
+	}
+
+	// Processing Store Instruction: a constant only overwrites an address
+	// that already has an interval
+	void processStore(const IntervalOp &op, FlatIntervalState &state)
+	{
+		STATS_COUNT(stats, "processStore");
+		if (op.lhs.isConstant)
+		{
+			if (state.has(op.result))
+				assign(state, op.result, Interval(op.lhs.value, op.lhs.value));
+		}
+		else if (state.has(op.lhs.id))
+			state.set(op.result, state.lower[op.lhs.id], state.upper[op.lhs.id]);
+	}
+
+	// Processing Load Instruction
+	void processLoad(const IntervalOp &op, FlatIntervalState &state)
+	{
+		STATS_COUNT(stats, "processLoad");
+		Interval loaded = extractInterval(op.lhs, state);
+		if (!loaded.isEmpty())
+			assign(state, op.result, loaded);
+	}
+
+	void processAdd(const IntervalOp &op, FlatIntervalState &state)
+	{
+		STATS_COUNT(stats, "processAdd");
+		Interval one = extractInterval(op.lhs, state);
+		Interval two = extractInterval(op.rhs, state);
+		if (one.isEmpty() || two.isEmpty())
+			return;
+		int lower = NEG_INF;
+		int upper = POS_INF;
+		if (one.getLower() != NEG_INF && two.getLower() != NEG_INF)
+			lower = one.getLower() + two.getLower();
+		if (one.getUpper() != POS_INF && two.getUpper() != POS_INF)
+			upper = one.getUpper() + two.getUpper();
+		assign(state, op.result, Interval(lower, upper));
+	}
+
+	void processSub(const IntervalOp &op, FlatIntervalState &state)
+	{
+		STATS_COUNT(stats, "processSub");
+		Interval one = extractInterval(op.lhs, state);
+		Interval two = extractInterval(op.rhs, state);
+		if (one.isEmpty() || two.isEmpty())
+			return;
+		int lower = NEG_INF;
+		int upper = POS_INF;
+		if (one.getLower() != NEG_INF && two.getUpper() != POS_INF)
+			lower = one.getLower() - two.getUpper();
+		if (one.getUpper() != POS_INF && two.getLower() != NEG_INF)
+			upper = one.getUpper() - two.getLower();
+		assign(state, op.result, Interval(lower, upper));
+	}
+
+	void processMul(const IntervalOp &op, FlatIntervalState &state)
+	{
+		STATS_COUNT(stats, "processMul");
+		Interval one = extractInterval(op.lhs, state);
+		Interval two = extractInterval(op.rhs, state);
+		if (one.isEmpty() || two.isEmpty())
+			return;
+		int tmp[] = {one.getLower() * two.getLower(), one.getUpper() * two.getUpper(),
+					 one.getLower() * two.getUpper(), one.getUpper() * two.getLower()};
+		assign(state, op.result, Interval(*std::min_element(tmp, tmp + 4), *std::max_element(tmp, tmp + 4)));
+	}
+
+	void processDiv(const IntervalOp &op, FlatIntervalState &state)
+	{
+		STATS_COUNT(stats, "processDiv");
+		Interval one = extractInterval(op.lhs, state);
+		Interval two = extractInterval(op.rhs, state);
+		if (one.isEmpty() || two.isEmpty())
+			return;
+		if (two.getLower() == 0 && two.getUpper() == 0)
+		{
+			assign(state, op.result, Interval(NEG_INF, POS_INF));
+		}
+		int tmp[8];
+		int n = 0;
+		if (two.getUpper() == 0)
+		{
+			tmp[n++] = one.getLower() * (-1);
+			tmp[n++] = one.getUpper() * (-1);
+			tmp[n++] = one.getLower() / two.getLower();
+			tmp[n++] = one.getUpper() / two.getLower();
+		}
+		else if (two.getLower() == 0)
+		{
+			tmp[n++] = one.getLower();
+			tmp[n++] = one.getUpper();
+			tmp[n++] = one.getLower() / two.getUpper();
+			tmp[n++] = one.getUpper() / two.getUpper();
+		}
+		else if (two.getUpper() > 0 and two.getLower() < 0)
+		{
+			tmp[n++] = one.getLower() * (-1);
+			tmp[n++] = one.getUpper() * (-1);
+			tmp[n++] = one.getLower() / two.getLower();
+			tmp[n++] = one.getUpper() / two.getLower();
+
+			tmp[n++] = one.getLower();
+			tmp[n++] = one.getUpper();
+			tmp[n++] = one.getLower() / two.getUpper();
+			tmp[n++] = one.getUpper() / two.getUpper();
+		}
+		else
+		{
+			tmp[n++] = one.getLower() / two.getLower();
+			tmp[n++] = one.getUpper() / two.getLower();
+			tmp[n++] = one.getLower() / two.getUpper();
+			tmp[n++] = one.getUpper() / two.getUpper();
+		}
+		assign(state, op.result, Interval(*std::min_element(tmp, tmp + n), *std::max_element(tmp, tmp + n)));
+	}
+
+	void processRem(const IntervalOp &op, FlatIntervalState &state)
+	{
+		STATS_COUNT(stats, "processRem");
+		Interval one = extractInterval(op.lhs, state);
+		Interval two = extractInterval(op.rhs, state);
+		if (one.isEmpty() || two.isEmpty())
+			return;
+
+		if (one.getUpper() == POS_INF && two.getUpper() == POS_INF)
+			assign(state, op.result, Interval(0, POS_INF));
+		else if (one.getUpper() == POS_INF)
+			assign(state, op.result, Interval(0, two.getUpper() - 1));
+		else if (two.getUpper() == POS_INF)
+			assign(state, op.result, Interval(0, one.getUpper()));
+		else if (one.getUpper() < two.getUpper())
+			assign(state, op.result, Interval(0, one.getUpper()));
+		else
+			assign(state, op.result, Interval(0, two.getUpper() - 1));
+	}
+};
+
+#endif
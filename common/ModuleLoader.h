@@ -0,0 +1,72 @@
+#ifndef CS5218_MODULE_LOADER_H
+#define CS5218_MODULE_LOADER_H
+
+#include <cstdio>
+#include <string>
+
+#include "llvm/IR/LLVMContext.h"
+#include "llvm/IR/Module.h"
+#include "llvm/IRReader/IRReader.h"
+#include "llvm/Support/SourceMgr.h"
+
+#ifdef CS5218_CLANG_FRONTEND
+#include "clang/CodeGen/CodeGenAction.h"
+#include "clang/Frontend/CompilerInstance.h"
+#include "clang/Frontend/CompilerInvocation.h"
+#include "clang/Frontend/Utils.h"
+
+// The bin directory of the LLVM install whose clang libraries the tool
+// links, from llvm-config --bindir (see the Readme build line)
+#ifndef CS5218_LLVM_BINDIR
+#error "the C frontend needs -DCS5218_LLVM_BINDIR=\"`llvm-config --bindir`\""
+#endif
+#endif
+
+//======================================================================
+// Loading the input module
+//======================================================================
+// A tool's input is an IR file (.ll or .bc), or a C source file (.c).
+// Built with -DCS5218_CLANG_FRONTEND and linked against the clang
+// libraries, a tool compiles C sources itself, straight into an in-memory
+// module: nothing is written to disk and no clang process is started. The
+// command line goes through the clang driver, as "clang -O0 -c" would, so
+// the header search is clang's own: its resource directory (stddef.h,
+// stdarg.h), the multiarch directory and the system ones. The driver is
+// named after the clang of the LLVM install the tool was built against
+// (CS5218_LLVM_BINDIR), and derives the resource directory from that path
+// and the version of the linked clang libraries, so the headers match the
+// compiler in the tool whatever clang is on PATH; the binary itself is
+// never run. -O0 keeps the allocas the analyses read. Without the frontend a C source is rejected with a hint to
+// compile it first.
+
+inline bool isCSource(const std::string &path)
+{
+	return path.size() > 2 && path.compare(path.size() - 2, 2, ".c") == 0;
+}
+
+// NULL when the file cannot be read, parsed or compiled; the reason has
+// been reported (IR errors are left in Err, as ParseIRFile does)
+inline llvm::Module *loadModule(const std::string &path, llvm::SMDiagnostic &Err, llvm::LLVMContext &Context)
+{
+	if (!isCSource(path))
+		return llvm::ParseIRFile(path, Err, Context);
+#ifdef CS5218_CLANG_FRONTEND
+	clang::CompilerInstance CI;
+	CI.createDiagnostics();
+	const char *args[] = {CS5218_LLVM_BINDIR "/clang", "-O0", "-x", "c", path.c_str()};
+	clang::CompilerInvocation *invocation = clang::createInvocationFromCommandLine(args, &CI.getDiagnostics());
+	if (invocation == NULL)
+		return NULL;
+	CI.setInvocation(invocation);
+	clang::EmitLLVMOnlyAction action(&Context);
+	if (!CI.ExecuteAction(action))
+		return NULL;
+	return action.takeModule();
+#else
+	fprintf(stderr, "error: \"%s\" is a C source; this build has no C frontend (see -DCS5218_CLANG_FRONTEND), "
+					"so compile it with clang -emit-llvm -S first\n", path.c_str());
+	return NULL;
+#endif
+}
+
+#endif
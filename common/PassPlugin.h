@@ -0,0 +1,59 @@
+#ifndef CS5218_PASS_PLUGIN_H
+#define CS5218_PASS_PLUGIN_H
+
+#include <cstdio>
+#include <fstream>
+#include <string>
+
+#include "llvm/IR/Module.h"
+
+//======================================================================
+// Running a tool as a pass plugin (built with -DCS5218_PLUGIN)
+//======================================================================
+// Built as a shared object with -DCS5218_PLUGIN, a tool leaves out its
+// main() and registers its analysis as a function pass instead, which runs
+// on the in-memory module, so no .ll file is written or parsed:
+//
+//     opt -load ./part2.so -cs5218-intervals -disable-output test1.ll
+//     clang -c -Xclang -load -Xclang ./part2.so test1.c
+//
+// Under clang the pass is added at the start of the function pipeline,
+// before any optimization removes the allocas the analyses read, so it
+// runs at every -O level. It only reads the IR. The report goes to the
+// file named by the tool's -cs5218-<pass>-output option (with clang:
+// -mllvm -cs5218-intervals-output=file). Without that option the report
+// takes the input's base name with the tool's suffix and is written to
+// the current directory. A pass cannot see the object file's name, so the
+// report does not follow clang -c -o dir/test1.o into dir.
+
+// Where the report for M goes: option when set, else "<input stem><suffix>"
+inline std::string pluginOutputPath(const llvm::Module &M, const std::string &option, const char *suffix)
+{
+	if (!option.empty())
+		return option;
+	std::string name = M.getModuleIdentifier();
+	size_t slash = name.find_last_of('/');
+	if (slash != std::string::npos)
+		name = name.substr(slash + 1);
+	size_t dot = name.find_last_of('.');
+	if (dot != std::string::npos && dot != 0)
+		name = name.substr(0, dot);
+	if (name.empty() || name == "-")
+		name = "stdin";
+	return name + suffix;
+}
+
+inline bool writePluginOutput(const std::string &path, const std::string &report)
+{
+	std::ofstream out(path.c_str());
+	out << report;
+	out.close();
+	if (!out)
+	{
+		fprintf(stderr, "error: cannot write analysis report to \"%s\"\n", path.c_str());
+		return false;
+	}
+	return true;
+}
+
+#endif
@@ -0,0 +1,198 @@
+#ifndef CS5218_POINTS_TO_H
+#define CS5218_POINTS_TO_H
+
+#include <utility>
+#include <vector>
+
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/IR/Constants.h"
+#include "llvm/IR/Function.h"
+#include "llvm/IR/GlobalVariable.h"
+#include "llvm/IR/Instructions.h"
+
+//======================================================================
+// Unification-based (Steensgaard) points-to analysis
+//======================================================================
+// Every pointer-carrying value and every memory object (alloca or global)
+// is a node; nodes are merged with union-find, and each equivalence class
+// points to at most one other class. Assignments unify the classes on
+// both sides instead of adding subset edges, so one pass over the function
+// with path compression and union by rank runs in almost linear time. The
+// result is flow- and field-insensitive: loads and stores anywhere in F
+// are treated alike, and a GEP or cast points where its base points. Calls
+// are not followed, so pointers escaping into callees are not tracked.
+class PointsToGraph
+{
+  public:
+	enum { NONE = ~0u };
+
+	explicit PointsToGraph(llvm::Function *F)
+	{
+		for (auto &BB : *F)
+		{
+			for (auto &I : BB)
+				addConstraints(&I);
+		}
+	}
+
+	// Class of the memory objects address may point to, or NONE when
+	// nothing is known about it.
+	unsigned pointee(llvm::Value *address)
+	{
+		unsigned n = find(valueNode(address));
+		return pts[n] == NONE ? NONE : find(pts[n]);
+	}
+
+	// Allocas and globals in a pointee class
+	const std::vector<const llvm::Value *> &objectsIn(unsigned cls)
+	{
+		return objects[find(cls)];
+	}
+
+	// A store through address overwrites exactly one object only when the
+	// address is that object itself and nothing else shares its class.
+	bool isSingleObject(llvm::Value *address)
+	{
+		llvm::Value *base = address->stripPointerCasts();
+		if (!llvm::isa<llvm::AllocaInst>(base) && !llvm::isa<llvm::GlobalVariable>(base))
+			return false;
+		unsigned cls = pointee(address);
+		return cls != NONE && objects[cls].size() == 1;
+	}
+
+	unsigned numNodes() const { return parent.size(); }
+
+  private:
+	std::vector<unsigned> parent;
+	std::vector<unsigned> rank;
+	std::vector<unsigned> pts;
+	std::vector<std::vector<const llvm::Value *> > objects;
+	llvm::DenseMap<const llvm::Value *, unsigned> valueNodes;
+	llvm::DenseMap<const llvm::Value *, unsigned> objectNodes;
+
+	unsigned newNode()
+	{
+		parent.push_back(parent.size());
+		rank.push_back(0);
+		pts.push_back(NONE);
+		objects.push_back(std::vector<const llvm::Value *>());
+		return parent.size() - 1;
+	}
+
+	unsigned find(unsigned n)
+	{
+		unsigned root = n;
+		while (parent[root] != root)
+			root = parent[root];
+		while (parent[n] != root)
+		{
+			unsigned next = parent[n];
+			parent[n] = root;
+			n = next;
+		}
+		return root;
+	}
+
+	// Merge two classes, and then (iteratively) the classes they point to
+	void join(unsigned a, unsigned b)
+	{
+		std::vector<std::pair<unsigned, unsigned> > pending(1, std::make_pair(a, b));
+		while (!pending.empty())
+		{
+			unsigned x = find(pending.back().first);
+			unsigned y = find(pending.back().second);
+			pending.pop_back();
+			if (x == y)
+				continue;
+			if (rank[x] < rank[y])
+				std::swap(x, y);
+			if (rank[x] == rank[y])
+				rank[x]++;
+			parent[y] = x;
+			objects[x].insert(objects[x].end(), objects[y].begin(), objects[y].end());
+			objects[y].clear();
+			if (pts[x] == NONE)
+				pts[x] = pts[y];
+			else if (pts[y] != NONE)
+				pending.push_back(std::make_pair(pts[x], pts[y]));
+		}
+	}
+
+	// Class pointed to by n's class, created empty on first use
+	unsigned deref(unsigned n)
+	{
+		n = find(n);
+		if (pts[n] == NONE)
+		{
+			unsigned target = newNode();
+			pts[n] = target;
+		}
+		return find(pts[n]);
+	}
+
+	unsigned objectNode(const llvm::Value *object)
+	{
+		auto it = objectNodes.find(object);
+		if (it != objectNodes.end())
+			return it->second;
+		unsigned n = newNode();
+		objects[n].push_back(object);
+		objectNodes[object] = n;
+		return n;
+	}
+
+	// Node for the pointer held by v. Constant casts and GEPs share their
+	// base's node; a global's node points to the global's object.
+	unsigned valueNode(llvm::Value *v)
+	{
+		if (llvm::ConstantExpr *CE = llvm::dyn_cast<llvm::ConstantExpr>(v))
+		{
+			if (CE->isCast() || CE->getOpcode() == llvm::Instruction::GetElementPtr)
+				return valueNode(CE->getOperand(0));
+		}
+		auto it = valueNodes.find(v);
+		if (it != valueNodes.end())
+			return it->second;
+		unsigned n = newNode();
+		valueNodes[v] = n;
+		if (llvm::isa<llvm::GlobalVariable>(v))
+			join(deref(n), objectNode(v));
+		return n;
+	}
+
+	void addConstraints(llvm::Instruction *I)
+	{
+		using namespace llvm;
+		if (isa<AllocaInst>(I))
+		{
+			// a = alloca: a points to a fresh object
+			join(deref(valueNode(I)), objectNode(I));
+		}
+		else if (LoadInst *load = dyn_cast<LoadInst>(I))
+		{
+			// x = *p
+			join(deref(valueNode(load)), deref(deref(valueNode(load->getPointerOperand()))));
+		}
+		else if (StoreInst *store = dyn_cast<StoreInst>(I))
+		{
+			// *p = v
+			join(deref(deref(valueNode(store->getPointerOperand()))), deref(valueNode(store->getValueOperand())));
+		}
+		else if (isa<CastInst>(I) || isa<GetElementPtrInst>(I))
+		{
+			join(deref(valueNode(I)), deref(valueNode(I->getOperand(0))));
+		}
+		else if (PHINode *phi = dyn_cast<PHINode>(I))
+		{
+			for (unsigned i = 0; i < phi->getNumIncomingValues(); i++)
+				join(deref(valueNode(phi)), deref(valueNode(phi->getIncomingValue(i))));
+		}
+		else if (SelectInst *select = dyn_cast<SelectInst>(I))
+		{
+			join(deref(valueNode(select)), deref(valueNode(select->getTrueValue())));
+			join(deref(valueNode(select)), deref(valueNode(select->getFalseValue())));
+		}
+	}
+};
+
+#endif
@@ -0,0 +1,200 @@
+#ifndef CS5218_PRE_PASS_H
+#define CS5218_PRE_PASS_H
+
+#include <cstring>
+#include <map>
+#include <set>
+#include <string>
+#include <vector>
+
+#include "llvm/IR/BasicBlock.h"
+#include "llvm/IR/CFG.h"
+#include "llvm/IR/Constants.h"
+#include "llvm/IR/Function.h"
+#include "llvm/IR/Instructions.h"
+#include "llvm/Transforms/Utils/BasicBlockUtils.h"
+#include "llvm/Transforms/Utils/Local.h"
+
+// Every tool prints blocks through its own getSimpleNodeLabel().
+std::string getSimpleNodeLabel(const llvm::BasicBlock *Node);
+
+//======================================================================
+// CFG pre-passes (--prepass=list)
+//======================================================================
+// Small in-process rewrites that shrink the CFG clang -O0 emits before an
+// analysis builds its BlockGraph, done by LLVM's own utilities
+// (ConstantFoldTerminator, removeUnreachableBlocks,
+// TryToSimplifyUncondBranchFromEmptyBlock, MergeBlockIntoPredecessor):
+//
+//     fold      a conditional branch on a constant, or on an icmp of two
+//               constants, becomes an unconditional one
+//     dce       blocks the entry cannot reach are deleted (newer LLVM's
+//               removeUnreachableBlocks() folds branches on a constant
+//               while looking for them, so this can take out more)
+//     forward   a block holding nothing but "br label %X" is bypassed
+//     merge     a block with a single predecessor, whose only successor it
+//               is, is appended to that predecessor
+//
+// Allocas, loads and stores are left alone, since every analysis here
+// reads its variables from them, so variable names are unchanged. Blocks
+// keep the labels they had before the rewrite (see prePassLabels()); a
+// merged block is printed under the label of its last part, whose exit
+// state it reports, and deleted or bypassed blocks are not reported.
+struct PrePassOptions
+{
+	bool fold;
+	bool dce;
+	bool forward;
+	bool merge;
+	PrePassOptions() : fold(false), dce(false), forward(false), merge(false) {}
+	bool any() const { return fold || dce || forward || merge; }
+};
+
+// Parses a comma-separated list of pass names, or "all"
+inline bool parsePrePasses(const char *list, PrePassOptions &options)
+{
+	std::string names(list);
+	size_t start = 0;
+	while (start <= names.size())
+	{
+		size_t end = names.find(',', start);
+		if (end == std::string::npos)
+			end = names.size();
+		std::string name = names.substr(start, end - start);
+		if (name == "fold")
+			options.fold = true;
+		else if (name == "dce")
+			options.dce = true;
+		else if (name == "forward")
+			options.forward = true;
+		else if (name == "merge")
+			options.merge = true;
+		else if (name == "all")
+			options.fold = options.dce = options.forward = options.merge = true;
+		else
+		{
+			fprintf(stderr, "error: unknown pre-pass \"%s\" (expected fold, dce, forward, merge or all)\n", name.c_str());
+			return false;
+		}
+		start = end + 1;
+	}
+	return true;
+}
+
+// Labels blocks had before the pre-passes; getSimpleNodeLabel() prefers
+// these, so the output names the blocks of the original IR.
+inline std::map<const llvm::BasicBlock *, std::string> &prePassLabels()
+{
+	static std::map<const llvm::BasicBlock *, std::string> labels;
+	return labels;
+}
+
+namespace prepass
+{
+
+// ConstantFoldTerminator() only folds a constant condition, so an icmp of
+// two constants is folded into one first
+inline bool foldBranches(llvm::Function &F)
+{
+	using namespace llvm;
+	bool changed = false;
+	for (auto &BB : F)
+	{
+		BranchInst *br = dyn_cast<BranchInst>(BB.getTerminator());
+		ICmpInst *cmp = br != NULL && br->isConditional() ? dyn_cast<ICmpInst>(br->getCondition()) : NULL;
+		if (cmp != NULL && isa<ConstantInt>(cmp->getOperand(0)) && isa<ConstantInt>(cmp->getOperand(1)))
+		{
+			br->setCondition(ConstantExpr::getICmp(cmp->getPredicate(), cast<Constant>(cmp->getOperand(0)), cast<Constant>(cmp->getOperand(1))));
+			if (cmp->use_empty())
+				cmp->eraseFromParent();
+		}
+		changed |= ConstantFoldTerminator(&BB);
+	}
+	return changed;
+}
+
+// A block that only branches on. It is bypassed unless a predecessor
+// already has an edge to its target: the analyses tell the arms of a
+// conditional branch apart by their target blocks.
+inline bool forwardEmptyBlocks(llvm::Function &F)
+{
+	using namespace llvm;
+	bool changed = false;
+	for (Function::iterator it = F.begin(); it != F.end();)
+	{
+		BasicBlock *BB = &*it++;
+		BranchInst *br = dyn_cast<BranchInst>(BB->getTerminator());
+		if (BB == &F.getEntryBlock() || br == NULL || br->isConditional() || BB->getFirstNonPHIOrDbg() != br)
+			continue;
+		BasicBlock *target = br->getSuccessor(0);
+		bool ambiguous = false;
+		for (pred_iterator pred = pred_begin(BB), end = pred_end(BB); pred != end && !ambiguous; ++pred)
+		{
+			for (succ_iterator succ = succ_begin(*pred), send = succ_end(*pred); succ != send; ++succ)
+			{
+				if (*succ == target)
+					ambiguous = true;
+			}
+		}
+		if (!ambiguous && TryToSimplifyUncondBranchFromEmptyBlock(BB))
+			changed = true;
+	}
+	return changed;
+}
+
+inline bool mergeBlocks(llvm::Function &F)
+{
+	using namespace llvm;
+	bool changed = false;
+	for (Function::iterator it = F.begin(); it != F.end();)
+	{
+		BasicBlock *BB = &*it++;
+		BasicBlock *pred = BB->getSinglePredecessor();
+		std::string label = prePassLabels()[BB];
+		if (pred == NULL || !MergeBlockIntoPredecessor(BB))
+			continue;
+		// pred now reports BB's exit state, so it takes BB's label
+		prePassLabels()[pred] = label;
+		changed = true;
+	}
+	return changed;
+}
+
+} // namespace prepass
+
+// Runs the selected passes on F until none changes it
+inline void runPrePasses(llvm::Function &F, const PrePassOptions &options)
+{
+	if (!options.any())
+		return;
+	std::vector<const llvm::BasicBlock *> blocks;
+	for (auto &BB : F)
+	{
+		prePassLabels()[&BB] = getSimpleNodeLabel(&BB);
+		blocks.push_back(&BB);
+	}
+	bool changed = true;
+	while (changed)
+	{
+		changed = false;
+		if (options.fold)
+			changed |= prepass::foldBranches(F);
+		if (options.dce)
+			changed |= llvm::removeUnreachableBlocks(F);
+		if (options.forward)
+			changed |= prepass::forwardEmptyBlocks(F);
+		if (options.merge)
+			changed |= prepass::mergeBlocks(F);
+	}
+	// The LLVM utilities delete blocks without telling us: drop their labels
+	std::set<const llvm::BasicBlock *> remaining;
+	for (auto &BB : F)
+		remaining.insert(&BB);
+	for (size_t i = 0; i < blocks.size(); i++)
+	{
+		if (remaining.count(blocks[i]) == 0)
+			prePassLabels().erase(blocks[i]);
+	}
+}
+
+#endif
@@ -0,0 +1,246 @@
+#ifndef CS5218_STATE_SPILL_H
+#define CS5218_STATE_SPILL_H
+
+#include <cctype>
+#include <cerrno>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+#include "FlatIntervalState.h"
+
+//======================================================================
+// Memory budget for block states (--memory-budget=size)
+//======================================================================
+// Keeps the arrays of the blocks' stored states under a byte budget. A
+// state must be touch()ed before it is read or written, which reloads it
+// if it was spilled, and charge()d after it changed size. While the
+// resident states exceed the budget, the least recently touched ones are
+// written to an anonymous scratch file (tmpfile(), deleted on exit) and
+// their arrays freed. The resident, non-empty states are kept on a list in
+// order of use, coldest first, so finding the state to spill is constant
+// time however many blocks there are. Under the SCC schedule those are the blocks of
+// components that are already solved, which are only read again by later
+// successors and when the results are printed, one block at a time.
+//
+// A state that was not changed since it was last written keeps its copy in
+// the file and is dropped without writing it again. A slot is reused when
+// the state still fits, and the state otherwise goes to the end of the
+// file.
+class StateSpill
+{
+  public:
+	StateSpill() : budget(0), file(NULL), fileEnd(0), resident(0), peak(0), coldest(NONE), hottest(NONE), spills(0), reloads(0) {}
+	~StateSpill() { closeFile(); }
+
+	// 0 disables the budget
+	void enable(size_t budgetBytes) { budget = budgetBytes; }
+	bool isEnabled() const { return budget != 0; }
+
+	// Start over with numBlocks empty, resident states
+	void reset(unsigned numBlocks)
+	{
+		closeFile();
+		slots.assign(numBlocks, Slot());
+		resident = 0;
+		coldest = hottest = NONE;
+	}
+
+	// Make states[b] resident and mark it as the most recently used; a
+	// reload may spill colder states to make room
+	void touch(std::vector<FlatIntervalState> &states, unsigned b)
+	{
+		if (!isEnabled())
+			return;
+		Slot &slot = slots[b];
+		if (!slot.spilled)
+		{
+			if (slot.bytes != 0)
+				makeHottest(b);
+			return;
+		}
+		FlatIntervalState &state = states[b];
+		state.lower.resize(slot.numVars);
+		state.upper.resize(slot.numVars);
+		size_t bytes = slot.numVars * sizeof(int32_t);
+		if (fseek(file, slot.offset, SEEK_SET) != 0 || fread(state.lower.data(), 1, bytes, file) != bytes ||
+			fread(state.upper.data(), 1, bytes, file) != bytes)
+			fail("read");
+		slot.spilled = false;
+		slot.bytes = footprint(state);
+		resident += slot.bytes;
+		reloads++;
+		if (slot.bytes != 0)
+			makeHottest(b);
+		while (resident > budget && spillColdest(states, b))
+			;
+	}
+
+	// Recount states[b] after it changed, then spill other states until the
+	// resident ones fit the budget again
+	void charge(std::vector<FlatIntervalState> &states, unsigned b)
+	{
+		if (!isEnabled())
+			return;
+		Slot &slot = slots[b];
+		resident -= slot.bytes;
+		slot.bytes = footprint(states[b]);
+		resident += slot.bytes;
+		slot.onDisk = false;
+		if (slot.bytes != 0)
+			makeHottest(b);
+		else
+			unlink(b);
+		if (resident > peak)
+			peak = resident;
+		while (resident > budget && spillColdest(states, b))
+			;
+	}
+
+	size_t peakBytes() const { return peak; }
+	unsigned long spillCount() const { return spills; }
+	unsigned long reloadCount() const { return reloads; }
+
+  private:
+	enum { NONE = ~0u };
+	struct Slot
+	{
+		bool spilled;
+		bool onDisk;		// the file holds the state as it is now
+		unsigned numVars;	// size of the state on disk
+		unsigned capacity;	// variables the file slot has room for
+		long offset;
+		size_t bytes;		// resident bytes
+		bool linked;		// on the use list
+		unsigned colder;	// neighbours on the use list, NONE at its ends
+		unsigned hotter;
+		Slot() : spilled(false), onDisk(false), numVars(0), capacity(0), offset(0), bytes(0), linked(false), colder(NONE), hotter(NONE) {}
+	};
+	size_t budget;
+	FILE *file;
+	long fileEnd;
+	size_t resident;
+	size_t peak;
+	unsigned coldest;	// ends of the use list
+	unsigned hottest;
+	unsigned long spills;
+	unsigned long reloads;
+	std::vector<Slot> slots;
+
+	static size_t footprint(const FlatIntervalState &state)
+	{
+		return (state.lower.capacity() + state.upper.capacity()) * sizeof(int32_t);
+	}
+
+	static void fail(const char *what)
+	{
+		fprintf(stderr, "error: cannot %s spilled block state: %s\n", what, strerror(errno));
+		exit(EXIT_FAILURE);
+	}
+
+	void closeFile()
+	{
+		if (file != NULL)
+			fclose(file);
+		file = NULL;
+		fileEnd = 0;
+	}
+
+	void unlink(unsigned b)
+	{
+		Slot &slot = slots[b];
+		if (!slot.linked)
+			return;
+		if (slot.colder != NONE)
+			slots[slot.colder].hotter = slot.hotter;
+		else
+			coldest = slot.hotter;
+		if (slot.hotter != NONE)
+			slots[slot.hotter].colder = slot.colder;
+		else
+			hottest = slot.colder;
+		slot.colder = slot.hotter = NONE;
+		slot.linked = false;
+	}
+
+	// Move b to the hot end of the use list, adding it if it is not on it
+	void makeHottest(unsigned b)
+	{
+		if (hottest == b)
+			return;
+		unlink(b);
+		Slot &slot = slots[b];
+		slot.colder = hottest;
+		if (hottest != NONE)
+			slots[hottest].hotter = b;
+		else
+			coldest = b;
+		hottest = b;
+		slot.linked = true;
+	}
+
+	// Spill the least recently used resident state other than keep; false
+	// when there is none left to spill
+	bool spillColdest(std::vector<FlatIntervalState> &states, unsigned keep)
+	{
+		unsigned b = coldest;
+		if (b == keep)
+			b = slots[b].hotter;
+		if (b == NONE)
+			return false;
+		unlink(b);
+		spill(states[b], slots[b]);
+		return true;
+	}
+
+	void spill(FlatIntervalState &state, Slot &slot)
+	{
+		if (!slot.onDisk)
+		{
+			if (file == NULL && (file = tmpfile()) == NULL)
+				fail("create file for");
+			if (state.size() > slot.capacity)
+			{
+				slot.offset = fileEnd;
+				slot.capacity = state.size();
+				fileEnd += 2 * (long)slot.capacity * sizeof(int32_t);
+			}
+			size_t bytes = state.size() * sizeof(int32_t);
+			if (fseek(file, slot.offset, SEEK_SET) != 0 || fwrite(state.lower.data(), 1, bytes, file) != bytes ||
+				fwrite(state.upper.data(), 1, bytes, file) != bytes)
+				fail("write");
+			slot.numVars = state.size();
+			slot.onDisk = true;
+		}
+		std::vector<int32_t>().swap(state.lower);
+		std::vector<int32_t>().swap(state.upper);
+		resident -= slot.bytes;
+		slot.bytes = 0;
+		slot.spilled = true;
+		spills++;
+	}
+};
+
+// Parses a byte count with an optional k, m or g suffix (powers of 1024)
+inline bool parseByteSize(const char *text, size_t &bytes)
+{
+	char *end;
+	errno = 0;
+	unsigned long long value = strtoull(text, &end, 10);
+	if (end == text || *text == '-' || errno == ERANGE)
+		return false;
+	const char *suffixes = "kmg";
+	const char *suffix = *end != '\0' ? strchr(suffixes, tolower(*end)) : NULL;
+	unsigned shift = suffix != NULL ? 10 * (suffix - suffixes + 1) : 0;
+	if (suffix != NULL)
+		end++;
+	if (*end != '\0' || value > (SIZE_MAX >> shift))
+		return false;
+	value <<= shift;
+	bytes = value;
+	return true;
+}
+
+#endif
@@ -0,0 +1,21 @@
+#ifndef CS5218_STRING_ESCAPE_H
+#define CS5218_STRING_ESCAPE_H
+
+#include <string>
+
+// Backslash-escapes quotes and backslashes, for a string written between
+// double quotes: the JSON of --stats and --trace and the DOT labels of
+// --profile-dot all take this form.
+inline std::string escapeString(const std::string &s)
+{
+	std::string out;
+	for (size_t i = 0; i < s.size(); i++)
+	{
+		if (s[i] == '"' || s[i] == '\\')
+			out += '\\';
+		out += s[i];
+	}
+	return out;
+}
+
+#endif
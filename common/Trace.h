@@ -0,0 +1,144 @@
+#ifndef CS5218_TRACE_H
+#define CS5218_TRACE_H
+
+#include <chrono>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include "StringEscape.h"
+
+//======================================================================
+// Chrome trace-event recorder (--trace=file)
+//======================================================================
+// Spans are written as complete ("X") events in the Trace Event Format,
+// which chrome://tracing and Perfetto open directly. Recording is off
+// until enable() is called; a TraceSpan then only tests one flag, so the
+// hooks can stay in the hot loops.
+class TraceRecorder
+{
+  public:
+	TraceRecorder() : enabled(false), origin(std::chrono::steady_clock::now()) {}
+
+	void enable() { enabled = true; }
+	bool isEnabled() const { return enabled; }
+
+	// microseconds since the recorder was created
+	double now() const
+	{
+		std::chrono::duration<double, std::micro> elapsed = std::chrono::steady_clock::now() - origin;
+		return elapsed.count();
+	}
+
+	// args is the body of a JSON object, e.g. "\"round\": 3", or empty
+	void addSpan(const std::string &name, const char *category, double start, double duration, const std::string &args)
+	{
+		Event event;
+		event.name = name;
+		event.category = category;
+		event.start = start;
+		event.duration = duration;
+		event.args = args;
+		events.push_back(event);
+	}
+
+	bool write(const char *path) const
+	{
+		FILE *out = fopen(path, "w");
+		if (out == NULL)
+		{
+			fprintf(stderr, "error: cannot write trace to \"%s\"\n", path);
+			return false;
+		}
+		fputs("{\"traceEvents\": [\n", out);
+		for (size_t i = 0; i < events.size(); i++)
+		{
+			const Event &e = events[i];
+			fprintf(out, "%s{\"name\": \"%s\", \"cat\": \"%s\", \"ph\": \"X\", \"pid\": 1, \"tid\": 1, \"ts\": %.3f, \"dur\": %.3f, \"args\": {%s}}",
+					i ? ",\n" : "", escapeString(e.name).c_str(), e.category, e.start, e.duration, e.args.c_str());
+		}
+		fputs("\n], \"displayTimeUnit\": \"ms\"}\n", out);
+		fclose(out);
+		return true;
+	}
+
+  private:
+	struct Event
+	{
+		std::string name;
+		const char *category;
+		double start;
+		double duration;
+		std::string args;
+	};
+	bool enabled;
+	std::chrono::steady_clock::time_point origin;
+	std::vector<Event> events;
+};
+
+// Records one span from construction until stop() or the end of the
+// enclosing scope; the name is only copied when tracing is on.
+class TraceSpan
+{
+  public:
+	TraceSpan(TraceRecorder &trace, const char *category, const char *name)
+		: trace(trace), category(category), active(trace.isEnabled())
+	{
+		if (active)
+			begin(name);
+	}
+	TraceSpan(TraceRecorder &trace, const char *category, const std::string &name)
+		: trace(trace), category(category), active(trace.isEnabled())
+	{
+		if (active)
+			begin(name);
+	}
+	~TraceSpan() { stop(); }
+
+	void stop()
+	{
+		if (!active)
+			return;
+		active = false;
+		trace.addSpan(name, category, start, trace.now() - start, args);
+	}
+
+	void arg(const char *key, const char *value)
+	{
+		if (active)
+			appendArg(key, "\"" + escapeString(value) + "\"");
+	}
+	void arg(const char *key, unsigned long value)
+	{
+		if (active)
+			appendArg(key, std::to_string(value));
+	}
+
+  private:
+	TraceRecorder &trace;
+	const char *category;
+	bool active;
+	std::string name;
+	std::string args;
+	double start;
+
+	TraceSpan(const TraceSpan &);
+	TraceSpan &operator=(const TraceSpan &);
+
+	void begin(const std::string &spanName)
+	{
+		name = spanName;
+		start = trace.now();
+	}
+	void appendArg(const char *key, const std::string &value)
+	{
+		if (!args.empty())
+			args += ", ";
+		args += "\"";
+		args += key;
+		args += "\": ";
+		args += value;
+	}
+};
+
+#endif